@@ -0,0 +1,88 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// static analysis of the RFC 5322 rules, or of the ABNF grammars given as arguments:
+// AnalyzeGrammar [--max-cost N] [file.abnf...]
+// Fails when a rule reads each character more than N times, when a repetition never ends or when a rule is left recursive
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "ParserIO.hpp"
+#include "ParserAnalyzer.hpp"
+#include "rfc5234/ABNFAnalyzer.hpp"
+#include "rfc5322/RFC5322Rules.hpp"
+
+static bool Check(GrammarAnalyzer const & grammar, size_t maxCost)
+{
+    grammar.Report(std::cout);
+
+    bool success(true);
+    for (auto const & ruleName : grammar.Rules())
+    {
+        size_t body(grammar.Rule(ruleName));
+        if (body != GrammarAnalyzer::NoExpr && grammar[body].Cost > maxCost)
+        {
+            std::cerr << "Rule " << ruleName << " reads each character up to " << GrammarAnalyzer::CostToString(grammar[body].Cost)
+                << " times, more than " << maxCost << std::endl;
+            success = false;
+        }
+    }
+    for (auto const & hazard : grammar.Hazards())
+    {
+        if (hazard.Kind == GrammarAnalyzer::Hazard::LeftRecursion)
+        {
+            std::cerr << "Rule " << hazard.Rule << " is left recursive: " << hazard.Detail << std::endl;
+            success = false;
+        }
+        if (hazard.Kind == GrammarAnalyzer::Hazard::NullableRepeat && hazard.Cost == GrammarAnalyzer::Unbounded)
+        {
+            std::cerr << "Rule " << hazard.Rule << ": " << hazard.Expression << " never ends" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+int main(int argc, char ** argv)
+{
+    size_t maxCost(GrammarAnalyzer::Unbounded);
+    std::vector<std::string> files;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (std::string(argv[arg]) == "--max-cost" && arg + 1 < argc)
+            maxCost = std::stoul(argv[++arg]);
+        else
+            files.push_back(argv[arg]);
+    }
+
+    bool success(true);
+    if (files.empty())
+    {
+        std::cout << "RFC 5322 address-list" << std::endl;
+        success = Check(AnalyzeRule(RFC5322::AddressList()), maxCost);
+    }
+
+    for (auto const & file : files)
+    {
+        std::cout << file << std::endl;
+        std::ifstream is(file, std::ios::binary);
+        std::stringstream abnf;
+        abnf << is.rdbuf();
+
+        GrammarAnalyzer grammar;
+        std::vector<std::string> errors;
+        if (!is || !ABNFMachine::Analyze(grammar, abnf.str(), errors))
+        {
+            std::cerr << "Error loading " << file << std::endl;
+            for (auto const & error : errors)
+                std::cerr << error << std::endl;
+            success = false;
+            continue;
+        }
+        success = Check(grammar, maxCost) && success;
+    }
+    return success ? 0 : 1;
+}
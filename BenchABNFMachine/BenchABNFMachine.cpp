@@ -0,0 +1,127 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// benchmark of the ABNF bytecode machine against the template rules on RFC 5322 addresses
+
+#include <string>
+#include <iostream>
+#include <chrono>
+
+#include "ParserIO.hpp"
+#include "rfc5234/ABNFMachine.hpp"
+#include "rfc5322/RFC5322Rules.hpp"
+
+// Same subset of https://tools.ietf.org/html/rfc5322 as RFC5322Rules.hpp, without the obsolete syntax
+static char const RFC5322Address[] =
+    "address-list    =   address *(\",\" address)\r\n"
+    "address         =   mailbox / group\r\n"
+    "mailbox         =   name-addr / addr-spec\r\n"
+    "name-addr       =   [display-name] angle-addr\r\n"
+    "angle-addr      =   [CFWS] \"<\" addr-spec \">\" [CFWS]\r\n"
+    "group           =   display-name \":\" [group-list] \";\" [CFWS]\r\n"
+    "display-name    =   phrase\r\n"
+    "mailbox-list    =   mailbox *(\",\" mailbox)\r\n"
+    "group-list      =   mailbox-list / CFWS\r\n"
+    "addr-spec       =   local-part \"@\" domain\r\n"
+    "local-part      =   dot-atom / quoted-string\r\n"
+    "domain          =   dot-atom / domain-literal\r\n"
+    "domain-literal  =   [CFWS] \"[\" *([FWS] dtext) [FWS] \"]\" [CFWS]\r\n"
+    "dtext           =   %d33-90 / %d94-126\r\n"
+    "phrase          =   1*word\r\n"
+    "word            =   atom / quoted-string\r\n"
+    "atom            =   [CFWS] 1*atext [CFWS]\r\n"
+    "dot-atom-text   =   1*atext *(\".\" 1*atext)\r\n"
+    "dot-atom        =   [CFWS] dot-atom-text [CFWS]\r\n"
+    "atext           =   ALPHA / DIGIT / \"!\" / \"#\" / \"$\" / \"%\" / \"&\" / \"'\" / \"*\" / \"+\" / \"-\" / \"/\" /\r\n"
+    "                    \"=\" / \"?\" / \"^\" / \"_\" / \"`\" / \"{\" / \"|\" / \"}\" / \"~\"\r\n"
+    "qtext           =   %d33 / %d35-91 / %d93-126\r\n"
+    "qcontent        =   qtext / quoted-pair\r\n"
+    "quoted-string   =   [CFWS] DQUOTE *([FWS] qcontent) [FWS] DQUOTE [CFWS]\r\n"
+    "quoted-pair     =   \"\\\" (VCHAR / WSP)\r\n"
+    "FWS             =   ([*WSP CRLF] 1*WSP)\r\n"
+    "ctext           =   %d33-39 / %d42-91 / %d93-126\r\n"
+    "ccontent        =   ctext / quoted-pair / comment\r\n"
+    "comment         =   \"(\" *([FWS] ccontent) [FWS] \")\"\r\n"
+    "CFWS            =   (1*([FWS] comment) [FWS]) / FWS\r\n";
+
+static std::string const Addresses[] =
+{
+    "troll@bitch.com, arobar     d <sigma@addr.net>, sir john snow <user.name+tag+sorting@example.com(comment)>",
+    "simple(comm1)@(comm2)example.com",
+    "disposable.style.email.with+symbol@example.com",
+    "\"john..doe\"@example.org, friends: rantanplan@lucky, titi@disney, dingo@disney;",
+    "a\"b(c)d,e:f;g<h>i[j\\k]l@example.com",
+    "1234567890123456789012345678901234567890123456789012345678901234+x@example.com",
+};
+
+template <typename FUNC>
+double Measure(size_t iterations, FUNC && func)
+{
+    auto start(std::chrono::high_resolution_clock::now());
+    for (size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (auto const & address : Addresses)
+        {
+            func(address);
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed(std::chrono::high_resolution_clock::now() - start);
+    return elapsed.count() / (iterations * (sizeof(Addresses) / sizeof(Addresses[0])));
+}
+
+int main(int argc, char ** argv)
+{
+    size_t const iterations = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    ABNFMachine::Program program;
+    if (!program.Load(RFC5322Address))
+    {
+        for (auto const & error : program.Errors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return EXIT_FAILURE;
+    }
+    std::cout << "Compiled RFC 5322 address rules in " << program.CodeSize() << " instructions" << std::endl;
+
+    auto addressList(program.Rule("address-list"));
+    for (auto const & address : Addresses)
+    {
+        auto parser(Make_ParserFromString(address));
+        AddressListData addresses;
+        bool templateResult(RFC5322::ParseExact(parser, &addresses));
+        bool machineResult(program.MatchExact(addressList, address.data(), address.data() + address.size()));
+        program.SetEngine("address-list", ABNFMachine::Engine::Earley);
+        bool earleyResult(program.MatchExact(addressList, address.data(), address.data() + address.size()));
+        program.SetEngine("address-list", ABNFMachine::Engine::Bytecode);
+        std::cout << address << ": template " << (templateResult ? "OK" : "KO") << ", machine " << (machineResult ? "OK" : "KO")
+            << ", earley " << (earleyResult ? "OK" : "KO") << std::endl;
+    }
+
+    size_t matched(0);
+    double templateTime(Measure(iterations, [&](std::string const & address)
+    {
+        auto parser(Make_ParserFromString(address));
+        AddressListData addresses;
+        matched += RFC5322::ParseExact(parser, &addresses) ? 1 : 0;
+    }));
+
+    double machineTime(Measure(iterations, [&](std::string const & address)
+    {
+        matched += program.MatchExact(addressList, address.data(), address.data() + address.size()) ? 1 : 0;
+    }));
+
+    program.SetEngine("address-list", ABNFMachine::Engine::Earley);
+    double earleyTime(Measure(iterations / 10, [&](std::string const & address)
+    {
+        matched += program.MatchExact(addressList, address.data(), address.data() + address.size()) ? 1 : 0;
+    }));
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "template rules:   " << templateTime << " us per address" << std::endl;
+    std::cout << "bytecode machine: " << machineTime << " us per address" << std::endl;
+    std::cout << "earley:           " << earleyTime << " us per address" << std::endl;
+    std::cout << "(" << matched << " matches)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
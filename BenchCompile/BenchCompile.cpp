@@ -0,0 +1,35 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// compile time and binary size benchmark: instantiates the parsing of the largest rules with their data.
+// The project passes /Bt+ so that the build log gives the compile time of this file, the program prints its size.
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "ParserIO.hpp"
+#include "rfc5234/RFC5324Rules.hpp"
+#include "rfc5322/RFC5322Rules.hpp"
+
+template <typename RULE, typename DATA>
+bool ParseString(std::string const & str)
+{
+    auto parser(Make_ParserFromString(str));
+    DATA data;
+    return ParseExact(parser, &data, RULE());
+}
+
+int main(int argc, char ** argv)
+{
+    bool parsed(ParseString<RFC5322::AddressList, AddressListData>("display <simple@example.com>, friends: titi@disney;")
+        && ParseString<RFC5234ABNF::rulelist, RFC5234ABNF::RuleListData>("rule = \"a\" / %x30-39 *(b)\r\n"));
+    std::cout << "parsing " << (parsed ? "OK" : "KO") << std::endl;
+
+    std::ifstream binary(argv[0], std::ios::binary | std::ios::ate);
+    if (binary)
+    {
+        std::cout << "binary size: " << binary.tellg() << " bytes" << std::endl;
+    }
+    return parsed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
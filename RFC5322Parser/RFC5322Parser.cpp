@@ -0,0 +1,24 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// the only translation unit instantiating the RFC 5322 grammar for the functions of RFC5322Parser.hpp
+
+#include "rfc5322/RFC5322Rules.hpp"
+#include "rfc5322/RFC5322Parser.hpp"
+
+namespace RFC5322
+{
+#define RFC5322_PARSER_DEFINITIONS(name) \
+    bool Parse(StringParser & parser, name##Data * result) { return Parse(parser, result, name()); } \
+    bool ParseExact(StringParser & parser, name##Data * result) { return ParseExact(parser, result, name()); } \
+    bool Parse(StreamParser & parser, name##Data * result) { return Parse(parser, result, name()); } \
+    bool ParseExact(StreamParser & parser, name##Data * result) { return ParseExact(parser, result, name()); }
+
+    RFC5322_PARSER_DEFINITIONS(AddressList)
+    RFC5322_PARSER_DEFINITIONS(MailboxList)
+    RFC5322_PARSER_DEFINITIONS(Mailbox)
+    RFC5322_PARSER_DEFINITIONS(AddrSpec)
+    RFC5322_PARSER_DEFINITIONS(AngleAddr)
+
+#undef RFC5322_PARSER_DEFINITIONS
+}
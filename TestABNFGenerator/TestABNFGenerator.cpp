@@ -4,8 +4,13 @@
 
 #define PARSER_LF_AS_CRLF
 
+#include <cassert>
+
 #include "ParserIO.hpp"
 #include "rfc5234/ABNFParserGenerator.hpp"
+#include "rfc5234/ABNFIncremental.hpp"
+#include "ParserBinary.hpp"
+#include "ParserHash.hpp"
 
 int main(int argc, char ** argv)
 {
@@ -77,6 +82,35 @@ prose-val      =  "<" *(%x20-3D / %x3F-7E) ">"
     {
         std::cout << "Success" << std::endl;
         GenerateABNFParser(std::cout, rules, parser.OutputBuffer());
+
+        // editing a rule only parses it again, and generates the same as parsing the whole text
+        IncrementalRuleList incremental;
+        assert(incremental.Reset(str));
+        size_t offset(str.find("1*BIT"));
+        str.replace(offset, 1, "2");
+        assert(incremental.Edit(offset, 1, "2"));
+        assert(incremental.LastParsed() < 200);
+
+        auto editedParser(Make_ParserFromString(str));
+        RuleListData editedRules;
+        assert(ParseExact(editedParser, &editedRules));
+        std::ostringstream expected, generated;
+        GenerateABNFParser(expected, editedRules, editedParser.OutputBuffer());
+        GenerateABNFParser(generated, incremental.Data(), incremental.OutputBuffer());
+        assert(expected.str() == generated.str());
+        assert(Equal(editedRules, editedParser.OutputBuffer(), incremental.Data(), incremental.OutputBuffer()));
+
+        // the rules read back from their binary form generate the same parser
+        std::vector<uint8_t> bytes;
+        WriteBinary(bytes, rules, parser.OutputBuffer());
+        RuleListData readRules;
+        ParserVector<char> readBuffer;
+        assert(ReadBinary(bytes.data(), bytes.size(), &readRules, &readBuffer) == bytes.size());
+        std::ostringstream original, read;
+        GenerateABNFParser(original, rules, parser.OutputBuffer());
+        GenerateABNFParser(read, readRules, readBuffer);
+        assert(original.str() == read.str());
+        assert(Equal(rules, readRules) && Hash(rules, parser.OutputBuffer()) == Hash(readRules, readBuffer));
     }
     else
     {
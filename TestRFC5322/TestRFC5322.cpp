@@ -5,17 +5,30 @@
 
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <cassert>
+#include <sstream>
 
 #include "ParserIO.hpp"
+#include "ParserValidate.hpp"
 #include "rfc5322/RFC5322Rules.hpp"
+#include "rfc5322/RFC5322NoCommentsRules.hpp"
+#include "rfc5322/RFC5322Incremental.hpp"
+#include "rfc5322/RFC5322FlatData.hpp"
+#include "ParserEvents.hpp"
+#include "rfc5322/RFC5322Canonical.hpp"
+#include "ParserArena.hpp"
+#include "ParserBinary.hpp"
+#include "ParserHash.hpp"
+#include <unordered_set>
 
 class PrintVisitor
 {
     static size_t const IndentationSpacing = 4;
     size_t indentation_ = 0;
-    std::vector<char> const & buffer_;
+    ParserVector<char> const & buffer_;
 public:
-    inline PrintVisitor(std::vector<char> const & buffer)
+    inline PrintVisitor(ParserVector<char> const & buffer)
     : buffer_(buffer)
     {
 
@@ -38,12 +51,101 @@ public:
 };
 
 
+#ifdef PARSER_CONSTEXPR_MATCH
+// literal addresses are checked and split at compile time
+static_assert(Valid<RFC5322::AddrSpec>("postmaster@example.com"), "valid addr-spec");
+static_assert(!Valid<RFC5322::AddrSpec>("Abc.example.com"), "invalid addr-spec");
+static_assert(Valid<RFC5322::AddressList>("\"john..doe\"@example.org, friends: rantanplan@lucky, titi@disney, dingo@disney;"), "valid address-list");
+static_assert(MatchEnd<RFC5322::LocalPart>("postmaster@example.com") == 10, "local-part of a literal");
+// as at runtime, a Cut() doesn't drop a longer match of the alternatives before it
+static_assert(MatchEnd<decltype(Alternatives(Literal<'a', 'b', 'c'>(), Sequence(CharVal<'a'>(), Cut(), CharVal<'b'>())))>("abc") == 3, "longer match before a cut");
+static_assert(MatchEnd<decltype(Alternatives(Literal<'a', 'b', 'c'>(), Sequence(CharVal<'a'>(), Cut(), CharVal<'c'>()), CharVal<'a'>()))>("abc") == Impl::ConstNoMatch, "failure after a cut");
+#endif
+
 void test_address(std::string const & addr)
 {
     std::cout << addr;
 
-    auto parser(Make_ParserFromString(addr));
     using namespace RFC5322;
+#ifdef PARSER_CONSTEXPR_MATCH
+    {
+        // the compile time matching agrees with the parser
+        auto parser(Make_ParserFromString(addr));
+        assert(ParseExact(parser, nullptr, AddressList()) == Valid<AddressList>(Impl::ConstInput(addr.data(), addr.size())));
+    }
+#endif
+
+    {
+        // skipping the comments changes the data, not what is valid
+        auto parser(Make_ParserFromString(addr));
+        AddrSpecData addrSpec;
+        bool isAddrSpec(ParseExact(parser, &addrSpec));
+        auto noCommentsParser(Make_ParserFromString(addr));
+        RFC5322NoComments::AddrSpecData noCommentsAddrSpec;
+        assert(RFC5322NoComments::ParseExact(noCommentsParser, &noCommentsAddrSpec) == isAddrSpec);
+        if (isAddrSpec)
+        {
+            // the parts keep their delimiters, the Content of the RFC5322 data doesn't
+            auto delimited = [](std::string const & part, std::string const & content, char open, char close)
+            {
+                return part == content || part == open + content + close;
+            };
+            std::string localPart(ToString(noCommentsParser.OutputBuffer(), noCommentsAddrSpec.LocalPart));
+            std::string domainPart(ToString(noCommentsParser.OutputBuffer(), noCommentsAddrSpec.DomainPart));
+            assert(delimited(localPart, ToString(parser.OutputBuffer(), false, addrSpec.LocalPart), '"', '"'));
+            assert(delimited(domainPart, ToString(parser.OutputBuffer(), false, addrSpec.DomainPart), '[', ']'));
+
+            // and still make an addr-spec once joined
+            auto joinedParser(Make_ParserFromString(localPart + "@" + domainPart));
+            RFC5322NoComments::AddrSpecData joined;
+            assert(RFC5322NoComments::ParseExact(joinedParser, &joined));
+            assert(ToString(joinedParser.OutputBuffer(), joined.LocalPart) == localPart);
+            assert(ToString(joinedParser.OutputBuffer(), joined.DomainPart) == domainPart);
+        }
+
+        // so does the parsing of a single part
+        auto domainParser(Make_ParserFromString(addr));
+        AddrSpecDomain domain;
+        assert(ParseExact(domainParser, &domain, AddrSpec()) == isAddrSpec);
+        assert(!isAddrSpec || ToString(domainParser.OutputBuffer(), domain.Get()) == ToString(parser.OutputBuffer(), addrSpec.DomainPart.Content));
+
+        auto listParser(Make_ParserFromString(addr));
+        bool isAddressList(ParseExact(listParser, nullptr, AddressList()));
+        auto noCommentsListParser(Make_ParserFromString(addr));
+        RFC5322NoComments::AddressListData noCommentsAddresses;
+        assert(RFC5322NoComments::ParseExact(noCommentsListParser, &noCommentsAddresses) == isAddressList);
+
+        // the flat data has the same addresses as the nested one
+        auto nestedParser(Make_ParserFromString(addr));
+        AddressListData nestedAddresses;
+        auto flatParser(Make_ParserFromString(addr));
+        FlatAddressListData flatAddresses;
+        assert(ParseExact(flatParser, &flatAddresses) == ParseExact(nestedParser, &nestedAddresses));
+        assert(flatAddresses.empty() || flatAddresses.size() == nestedAddresses.size());
+        for (size_t index = 0; index < flatAddresses.size(); ++index)
+        {
+            AddressData const & nested(nestedAddresses[index]);
+            auto flat(flatAddresses[index]);
+            assert(flat.IsGroup() == !nested.Group.DisplayName.empty());
+            if (flat.IsGroup())
+            {
+                assert(flat.Group().DisplayName().size() == nested.Group.DisplayName.size());
+                assert(flat.Group().Mailboxes().size() == nested.Group.GroupList.Mailboxes.size());
+            }
+            else
+            {
+                AddrSpecData const & addrSpec(flat.Mailbox().IsNameAddr() ? nested.Mailbox.NameAddr.Address.Content : nested.Mailbox.AddrSpec);
+                assert(ToString(flatParser.OutputBuffer(), false, flat.Mailbox().LocalPart()) == ToString(nestedParser.OutputBuffer(), false, addrSpec.LocalPart));
+                assert(ToString(flatParser.OutputBuffer(), false, flat.Mailbox().DomainPart()) == ToString(nestedParser.OutputBuffer(), false, addrSpec.DomainPart));
+            }
+        }
+
+        // so does the validation only parsing
+        assert(Validate<AddrSpec>(addr) == isAddrSpec);
+        assert(Validate<AddressList>(addr) == isAddressList);
+    }
+
+    auto parser(Make_ParserFromString(addr));
 
     MailboxData mailbox;
     ParseExact(parser, &mailbox);
@@ -56,6 +158,19 @@ void test_address(std::string const & addr)
 
         for (AddressData const & address : addresses)
         {
+            // the views show the same as the strings
+            for (bool withComments : { false, true })
+            {
+                NameAddrData const & nameAddr(address.Mailbox.NameAddr);
+                std::string displayName(ToString(parser.OutputBuffer(), withComments, nameAddr.DisplayName));
+                assert(ToStringView(parser.OutputBuffer(), withComments, nameAddr.DisplayName) == displayName);
+                assert(ToStringView(parser.OutputBuffer(), withComments, nameAddr.DisplayName).Length() == displayName.size());
+                std::ostringstream os;
+                os << ToStringView(parser.OutputBuffer(), withComments, address.Group.DisplayName);
+                assert(os.str() == ToString(parser.OutputBuffer(), withComments, address.Group.DisplayName));
+                assert(ToStringView(parser.OutputBuffer(), withComments, address.Mailbox.AddrSpec.LocalPart) == ToString(parser.OutputBuffer(), withComments, address.Mailbox.AddrSpec.LocalPart));
+                assert(ToStringView(parser.OutputBuffer(), nameAddr.Address.Content.DomainPart.Content) == ToString(parser.OutputBuffer(), nameAddr.Address.Content.DomainPart.Content));
+            }
             NamedTuple::Visit(address, PrintVisitor(parser.OutputBuffer()));
 
             continue;
@@ -70,8 +185,490 @@ void test_address(std::string const & addr)
     std::cout << std::endl;
 }
 
+// Looks for the addresses of a text, restarting the same parser after each of them
+void test_scan()
+{
+    using namespace RFC5322;
+
+    std::string text("Contact: john@example.com or (jane) jane.doe@example.org.");
+    std::vector<std::string> found;
+
+    auto parser(Make_ParserFromString(text));
+    ValidatorIO<char> validator(text.data(), text.size());
+    for (size_t pos = 0; pos < text.size();)
+    {
+        parser.Restart(pos);
+        validator.Restart(pos);
+
+        AddrSpecData addrSpec;
+        size_t length(ParsePrefix(parser, &addrSpec));
+        assert(ParsePrefix(validator, nullptr, AddrSpec()) == length);
+        if (length == PrefixNoMatch)
+        {
+            ++pos;
+            continue;
+        }
+        found.push_back(ToString(parser.OutputBuffer(), false, addrSpec.LocalPart) + "@" + ToString(parser.OutputBuffer(), false, addrSpec.DomainPart));
+        pos += length;
+    }
+
+    assert((found == std::vector<std::string>{ "john@example.com", "jane.doe@example.org" }));
+}
+
+// Member names and values, to compare data
+class DumpVisitor
+{
+    ParserVector<char> const & buffer_;
+    std::string & dump_;
+public:
+    inline DumpVisitor(ParserVector<char> const & buffer, std::string & dump)
+    : buffer_(buffer), dump_(dump)
+    {
+    }
+
+    template <typename MEMBER_INFO, typename CONTINUATION>
+    inline void OnMember(MEMBER_INFO const & memberInfo, SubstringPos memberValue, CONTINUATION && /* continuation */)
+    {
+        dump_ += std::string(memberInfo.GetName()) + "=" + ToString(buffer_, memberValue) + ";";
+    }
+
+    template <typename MEMBER_INFO, typename TYPE, typename CONTINUATION>
+    inline void OnMember(MEMBER_INFO const & memberInfo, TYPE const & /* memberValue */, CONTINUATION && continuation)
+    {
+        dump_ += std::string(memberInfo.GetName()) + "{";
+        continuation();
+        dump_ += "}";
+    }
+};
+
+std::string dump(AddressListData const & addresses, ParserVector<char> const & buffer)
+{
+    std::string result;
+    for (AddressData const & address : addresses)
+    {
+        NamedTuple::Visit(address, DumpVisitor(buffer, result));
+        result += "\n";
+    }
+    return result;
+}
+
+// Edits a list of addresses, the incremental parsing must give the same as parsing the whole text
+void test_incremental()
+{
+    using namespace RFC5322;
+
+    std::string text;
+    for (size_t index = 0; index < 20; ++index)
+    {
+        text += (index > 0 ? ", " : "") + (index % 3 == 0 ? "user" + std::to_string(index) + "@example.com" : "User (" + std::to_string(index) + ") <u" + std::to_string(index) + "@host.org>");
+    }
+
+    IncrementalAddressList list;
+    assert(list.Reset(text));
+
+    // random edits, every other one undone
+    std::string const insertions[] = { "x", " ", "(c)", ", a@b", "\"", ",", "<", "@", "" };
+    uint32_t random(12345);
+    size_t offset(0);
+    size_t removedCount(0);
+    std::string inserted;
+    std::string removed;
+    for (size_t step = 0; step < 60; ++step)
+    {
+        random = random * 1103515245 + 12345;
+        if (step % 2 == 0)
+        {
+            offset = (random >> 8) % (text.size() + 1);
+            removedCount = std::min<size_t>((random >> 4) % 3, text.size() - offset);
+            inserted = insertions[(random >> 20) % 9];
+        }
+        else
+        {
+            removedCount = inserted.size();
+            inserted = removed;
+        }
+        removed = text.substr(offset, removedCount);
+        text.replace(offset, removedCount, inserted);
+
+        bool valid(list.Edit(offset, removedCount, inserted));
+        assert(list.Text() == text);
+
+        auto parser(Make_ParserFromString(text));
+        AddressListData addresses;
+        assert(ParseExact(parser, &addresses) == valid);
+        assert(!valid || dump(addresses, parser.OutputBuffer()) == dump(list.Data(), list.OutputBuffer()));
+    }
+
+    // an edit in the middle of a valid list only parses the addresses around it
+    text = list.Text();
+    for (size_t index = 0; index < 200; ++index)
+    {
+        text += ", user" + std::to_string(index) + "@example.com";
+    }
+    list.Reset(text);
+    list.Edit(text.find("user100@") + 4, 3, "name");
+    assert(list.LastParsed() < 100);
+}
+
+// Dumps the streamed addresses, checks the nesting of the rules events
+class EventsVisitor
+{
+public:
+    ParserVector<char> const * Buffer = nullptr;
+    std::string Dump;
+    std::vector<std::string> Rules;
+    SubstringPos LastSpan;
+    std::function<size_t()> InputBuffered;
+    size_t MaxInputBuffered = 0;
+
+    inline void OnListElement(AddressData const & address)
+    {
+        NamedTuple::Visit(address, DumpVisitor(*Buffer, Dump));
+        Dump += "\n";
+        if (InputBuffered)
+            MaxInputBuffered = std::max(MaxInputBuffered, InputBuffered());
+    }
+
+    inline void OnBegin(char const * ruleName)
+    {
+        Rules.push_back(ruleName);
+    }
+
+    inline void OnEnd(char const * ruleName, SubstringPos inputSpan)
+    {
+        assert(Rules.back() == ruleName);
+        Rules.pop_back();
+        LastSpan = inputSpan;
+    }
+
+    inline void OnFail(char const * ruleName)
+    {
+        assert(Rules.back() == ruleName);
+        Rules.pop_back();
+    }
+};
+
+// Streams the addresses of a list, they must be the ones of the whole data
+void test_events()
+{
+    using namespace RFC5322;
+
+    std::string text;
+    for (size_t index = 0; index < 50; ++index)
+    {
+        text += (index > 0 ? ", " : "") + (index % 2 == 0 ? "user" + std::to_string(index) + "@example.com" : "User (" + std::to_string(index) + ") <u" + std::to_string(index) + "@host.org>");
+    }
+    text += ", friends: rantanplan@lucky, titi@disney;";
+
+    auto parser(Make_ParserFromString(text));
+    AddressListData addresses;
+    assert(ParseExact(parser, &addresses));
+
+    EventsVisitor visitor;
+    auto eventParser(Make_EventParser(Make_ParserFromString(text), visitor));
+    visitor.Buffer = &eventParser.OutputBuffer();
+    visitor.InputBuffered = [&eventParser]() { return eventParser.Input().ReadPos() - eventParser.Input().StartPos(); };
+    auto events(Make_ListEvents<AddressData>(visitor));
+    assert(ParseExact(eventParser, &events, AddressList()));
+    assert(events.Count() == addresses.size());
+    assert(visitor.Dump == dump(addresses, parser.OutputBuffer()));
+    assert(visitor.Rules.empty() && visitor.LastSpan == SubstringPos(0, text.size()));
+    // only one address at a time in the output, and in the input
+    assert(eventParser.OutputBuffer().size() < 100);
+    assert(visitor.MaxInputBuffered < 100);
+
+    // the input stays while an enclosing choice point can come back to it
+    EventsVisitor optionalVisitor;
+    auto optionalParser(Make_EventParser(Make_ParserFromString(text), optionalVisitor));
+    optionalVisitor.Buffer = &optionalParser.OutputBuffer();
+    optionalVisitor.InputBuffered = [&optionalParser]() { return optionalParser.Input().ReadPos() - optionalParser.Input().StartPos(); };
+    auto optionalEvents(Make_ListEvents<AddressData>(optionalVisitor));
+    assert(Parse(optionalParser, &optionalEvents, "optional", Optional(AddressList())) && optionalParser.Ended());
+    assert(optionalVisitor.Dump == visitor.Dump);
+    assert(optionalParser.Input().StartPos() == 0);
+}
+
+std::string canonical(std::string const & addr)
+{
+    using namespace RFC5322;
+
+    auto parser(Make_ParserFromString(addr));
+    MailboxData mailbox;
+    if (!ParseExact(parser, &mailbox))
+        return "invalid";
+    char dest[64];
+    size_t length(WriteCanonical(dest, sizeof(dest), parser.OutputBuffer(), mailbox));
+    assert(length <= sizeof(dest));
+    // a too small buffer gets the start of it, the length is the same
+    char smallDest[4];
+    assert(WriteCanonical(smallDest, sizeof(smallDest), parser.OutputBuffer(), mailbox) == length);
+    assert(std::string(smallDest, std::min(length, sizeof(smallDest))) == std::string(dest, std::min(length, sizeof(smallDest))));
+    return std::string(dest, length);
+}
+
+void test_canonical()
+{
+    assert(canonical("John.Doe@Example.COM") == "John.Doe@example.com");
+    assert(canonical("simple(comm1)@(comm2)Example.COM (comm3)") == "simple@example.com");
+    assert(canonical("Some One <\"john\"@Example.com>") == "john@example.com");
+    assert(canonical("\"\\j\\o\\h\\n\"@x") == "john@x");
+    assert(canonical("\"john doe\"@x") == "\"john doe\"@x");
+    assert(canonical("\"john..doe\"@x") == "\"john..doe\"@x");
+    assert(canonical("\"a\\\"b\"@x") == "\"a\\\"b\"@x");
+    assert(canonical("\"\"@x") == "\"\"@x");
+    assert(canonical("user@[ IPv6:ABCD::1 ]") == "user@[ipv6:abcd::1]");
+
+    // what is before the addr-spec in the output doesn't make its parts quoted
+    std::string text("\"x\"a..b@d.e[f.g");
+    ParserVector<char> buffer(text.begin(), text.end());
+    AddrSpecData addrSpec;
+    addrSpec.LocalPart.Content = SubstringPos(3, 7);
+    addrSpec.DomainPart.Content = SubstringPos(8, 11);
+    char dest[16];
+    assert(std::string(dest, WriteCanonical(dest, sizeof(dest), buffer, addrSpec)) == "a..b@d.e");
+    addrSpec.LocalPart.Content = SubstringPos(14, 15);
+    addrSpec.DomainPart.Content = SubstringPos(12, 13);
+    assert(std::string(dest, WriteCanonical(dest, sizeof(dest), buffer, addrSpec)) == "g@f");
+}
+
+// The vectors allocated in the scope of an arena take its memory, reused after a Reset()
+void test_arena()
+{
+    Arena arena(1024);
+    ParserVector<SubstringPos> positions(&arena);
+    positions.resize(10);
+    assert(positions.get_allocator().resource() == &arena && arena.Used() >= 10 * sizeof(SubstringPos));
+
+    using namespace RFC5322;
+
+    std::string text("troll@bitch.com, arobar     d <sigma@addr.net>, friends: rantanplan@lucky, titi@disney;");
+    size_t reserved(0);
+    for (size_t index = 0; index < 3; ++index)
+    {
+        arena.Reset();
+        auto parser(Make_ParserFromString(text, &arena));
+        auto addresses(Make_Data<AddressListData>(&arena));
+        assert(ParseExact(parser, &addresses) && addresses.size() == 3);
+        assert(parser.OutputBuffer().get_allocator().resource() == &arena);
+        // the temporary elements of the parsing are built in the arena, their vectors go to the data
+        assert(addresses[1].Mailbox.NameAddr.DisplayName.get_allocator().resource() == &arena);
+        assert(addresses[2].Group.GroupList.Mailboxes.get_allocator().resource() == &arena);
+        assert(addresses[2].Group.GroupList.Mailboxes[1].NameAddr.DisplayName.get_allocator().resource() == &arena);
+        assert(index == 0 || arena.Reserved() == reserved);
+        reserved = arena.Reserved();
+    }
+    // the other parsers still use the default resource
+    assert(std::pmr::get_default_resource() != &arena && Make_ParserFromString(text).Resource() == std::pmr::get_default_resource());
+
+    auto mailbox(Make_Data<MailboxData>(&arena));
+    auto parser(Make_ParserFromString(std::string("A (1) B C D E <x@y>"), &arena));
+    assert(ParseExact(parser, &mailbox) && mailbox.NameAddr.DisplayName.size() == 5);
+    assert(mailbox.NameAddr.DisplayName.get_allocator().resource() == &arena);
+}
+
+// The short lists of the data are inline, the longer ones go to the allocator
+void test_small_vector()
+{
+    using namespace RFC5322;
+
+    auto parser(Make_ParserFromString(std::string("Mister John Doe <john@example.com>")));
+    MailboxData mailbox;
+    assert(ParseExact(parser, &mailbox) && mailbox.NameAddr.DisplayName.size() == 3);
+    assert(mailbox.NameAddr.DisplayName.capacity() == 3);
+
+    auto longParser(Make_ParserFromString(std::string("A (1) B C D E <x@y>")));
+    MailboxData longMailbox;
+    assert(ParseExact(longParser, &longMailbox) && longMailbox.NameAddr.DisplayName.size() == 5);
+    assert(ToString(longParser.OutputBuffer(), false, longMailbox.NameAddr.DisplayName) == "A B C D E");
+
+    SmallVector<std::string, 2> words({ "a", "b", "c" });
+    SmallVector<std::string, 2> moved(std::move(words));
+    assert(words.empty() && moved.size() == 3 && moved[2] == "c");
+    moved.resize(1);
+    words = moved;
+    assert((words == SmallVector<std::string, 2>({ "a" })));
+
+    // the elements get the memory resource of the SmallVector, inline or not
+    Arena arena;
+    std::pmr::polymorphic_allocator<ParserVector<int> > allocator(&arena);
+    ParserSmallVector<ParserVector<int>, 1> lists(allocator);
+    lists.emplace_back();
+    lists.resize(3);
+    assert(lists[0].get_allocator().resource() == &arena && lists[2].get_allocator().resource() == &arena);
+}
+
+// Recycled data is empty, its vectors keep their memory for the next parsing
+void test_recycle()
+{
+    using namespace RFC5322;
+
+    AddressData address;
+    auto parser(Make_ParserFromString(std::string("friends: rantanplan@lucky, titi@disney, dingo@disney;")));
+    assert(ParseExact(parser, &address) && address.Group.GroupList.Mailboxes.size() == 3);
+    MailboxData const * mailboxes(address.Group.GroupList.Mailboxes.data());
+    size_t capacity(address.Group.GroupList.Mailboxes.capacity());
+
+    address.Recycle();
+    assert(IsEmpty(address) && address.Group.GroupList.Mailboxes.empty());
+    assert(address.Group.GroupList.Mailboxes.data() == mailboxes && address.Group.GroupList.Mailboxes.capacity() == capacity);
+
+    auto otherParser(Make_ParserFromString(std::string("enemies: joe@dalton, jack@dalton, william@dalton;")));
+    assert(ParseExact(otherParser, &address) && address.Group.GroupList.Mailboxes.data() == mailboxes);
+    assert(ToString(otherParser.OutputBuffer(), address.Group.GroupList.Mailboxes[2].AddrSpec.LocalPart.Content) == "william");
+
+    // so does a list reset on its own
+    AddressListData addresses;
+    auto listParser(Make_ParserFromString(std::string("a@x, b@y, c@z")));
+    assert(ParseExact(listParser, &addresses) && addresses.size() == 3);
+    AddressData const * elems(addresses.data());
+    Impl::ResetData(addresses);
+    assert(addresses.empty() && addresses.data() == elems);
+}
+
+// The data read back from its binary form is the same, with the characters it refers to
+void test_binary()
+{
+    using namespace RFC5322;
+
+    std::string text("troll@bitch.com, arobar     d <sigma@addr.net>, sir john snow <user.name+tag+sorting@example.com(comment)>, friends: rantanplan@lucky, titi@disney;");
+    auto parser(Make_ParserFromString(text));
+    AddressListData addresses;
+    assert(ParseExact(parser, &addresses));
+
+    std::vector<uint8_t> bytes;
+    WriteBinary(bytes, addresses, parser.OutputBuffer());
+    size_t size(bytes.size());
+    WriteBinary(bytes, addresses[0], parser.OutputBuffer());
+
+    AddressListData readAddresses;
+    ParserVector<char> readBuffer;
+    assert(ReadBinary(bytes.data(), bytes.size(), &readAddresses, &readBuffer) == size);
+    assert(dump(readAddresses, readBuffer) == dump(addresses, parser.OutputBuffer()));
+
+    // records follow each other
+    AddressData readAddress;
+    assert(ReadBinary(bytes.data() + size, bytes.size() - size, &readAddress, &readBuffer) == bytes.size() - size);
+    assert(ToString(readBuffer, readAddress.Mailbox.AddrSpec.LocalPart.Content) == "troll");
+
+    // truncated bytes are invalid
+    AddressListData truncated;
+    assert(ReadBinary(bytes.data(), size - 1, &truncated, &readBuffer) == 0);
+
+    // so are the positions before the start, the negative lengths, and the positions out of the buffer
+    SubstringPos pos;
+    uint8_t const valid[] = { 1, 2, 1, 'a' };
+    assert(ReadBinary(valid, sizeof(valid), &pos, &readBuffer) == sizeof(valid) && pos == SubstringPos(0, 1));
+    uint8_t const beforeStart[] = { 2, 0, 0 };
+    assert(ReadBinary(beforeStart, sizeof(beforeStart), &pos, &readBuffer) == 0);
+    uint8_t const negativeLength[] = { 1, 1, 0 };
+    assert(ReadBinary(negativeLength, sizeof(negativeLength), &pos, &readBuffer) == 0);
+    uint8_t const afterEnd[] = { 1, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0 };
+    assert(ReadBinary(afterEnd, sizeof(afterEnd), &pos, &readBuffer) == 0);
+
+    // a count of elements greater than the ones in the bytes doesn't allocate them
+    std::vector<uint8_t> overCount(200, 0);
+    overCount[0] = 199;
+    AddressListData overCounted;
+    assert(ReadBinary(overCount.data(), overCount.size(), &overCounted, &readBuffer) == 0);
+    assert(overCounted.capacity() < 199);
+}
+
+void test_hash()
+{
+    using namespace RFC5322;
+
+    auto parser1(Make_ParserFromString(std::string("troll@bitch.com, sir john snow <john@example.com>")));
+    AddressListData addresses1;
+    assert(ParseExact(parser1, &addresses1));
+    auto parser2(Make_ParserFromString(std::string("sigma@addr.net, sir john snow <john@example.com>")));
+    AddressListData addresses2;
+    assert(ParseExact(parser2, &addresses2));
+
+    // same text at other positions: equal by contents only
+    assert(Hash(addresses1[1], parser1.OutputBuffer()) == Hash(addresses2[1], parser2.OutputBuffer()));
+    assert(Equal(addresses1[1], parser1.OutputBuffer(), addresses2[1], parser2.OutputBuffer()));
+    assert(false == Equal(addresses1[0], parser1.OutputBuffer(), addresses2[0], parser2.OutputBuffer()));
+    assert(Equal(addresses1[1], addresses1[1]) && Hash(addresses1[1]) == Hash(addresses1[1]));
+    assert(false == Equal(addresses1[1], addresses2[1]));
+    assert(Hash(addresses1[1]) != Hash(addresses2[1]));
+
+    // deduplication without string keys, the spaces before the addresses are part of them
+    auto parser3(Make_ParserFromString(std::string(" a@x.org, b@y.org, a@x.org, b@x.org, a@x.org")));
+    AddressListData addresses3;
+    assert(ParseExact(parser3, &addresses3));
+    std::unordered_set<AddressData, DataContentHash<ParserVector<char> >, DataContentEqual<ParserVector<char> > > unique(0,
+        Make_DataContentHash(parser3.OutputBuffer()), Make_DataContentEqual(parser3.OutputBuffer()));
+    unique.insert(addresses3.begin(), addresses3.end());
+    assert(unique.size() == 3);
+
+    std::unordered_set<AddressData, DataHash, DataEqual> uniquePositions(addresses3.begin(), addresses3.end());
+    assert(uniquePositions.size() == 5);
+}
+
+void test_cut()
+{
+    // a Cut() doesn't release the input the enclosing rules can still go back to
+    {
+        auto parser(Make_ParserFromString(std::string("John <foo> ")));
+        NameAddrData nameAddr;
+        assert(false == RFC5322::ParseExact(parser, &nameAddr));
+        AddrSpecData addrSpec;
+        assert(false == RFC5322::ParseExact(parser, &addrSpec));
+        assert(ParsePrefix(parser, nullptr, RFC5322::DisplayName()) == 5);
+    }
+    {
+        auto parser(Make_ParserFromString(std::string("John <foo> ")));
+        RFC5322NoComments::NameAddrData nameAddr;
+        assert(false == RFC5322NoComments::ParseExact(parser, &nameAddr));
+        RFC5322NoComments::AddrSpecData addrSpec;
+        assert(false == RFC5322NoComments::ParseExact(parser, &addrSpec));
+    }
+    // the input released by a Cut() can't be parsed again
+    {
+        auto parser(Make_ParserFromString(std::string("John, <a@b>")));
+        assert(parser.Restart(6));
+        AngleAddrData angleAddr;
+        assert(RFC5322::ParseExact(parser, &angleAddr));
+        assert(false == parser.Restart(0) && false == parser.Restart(100) && parser.Restart(6));
+    }
+}
+
+void test_longest_match()
+{
+    // the input is rewound after a shorter match, the next alternatives start where the first one did
+    auto parser(Make_ParserFromString(std::string("abcd")));
+    assert(ParsePrefix(parser, nullptr, Alternatives(Literal<'a', 'b', 'c'>(), CharVal<'a'>(),
+        Sequence(CharVal<'a'>(), CharVal<'b'>(), CharVal<'c'>(), CharVal<'d'>()))) == 4);
+
+    // a Cut() doesn't drop a longer match of the alternatives before it
+    auto parser2(Make_ParserFromString(std::string("abc")));
+    assert(ParsePrefix(parser2, nullptr, Alternatives(Literal<'a', 'b', 'c'>(), Sequence(CharVal<'a'>(), Cut(), CharVal<'b'>()))) == 3);
+    auto parser3(Make_ParserFromString(std::string("abc")));
+    assert(ParsePrefix(parser3, nullptr, Alternatives(Literal<'a', 'b', 'c'>(), Sequence(CharVal<'a'>(), Cut(), CharVal<'c'>()), CharVal<'a'>())) == PrefixNoMatch);
+}
+
+// in TestRFC5322Library.cpp
+void test_library();
+
 int main(int argc, char ** argv)
 {
+    test_library();
+    test_longest_match();
+    test_cut();
+    test_hash();
+    test_binary();
+    test_recycle();
+    test_small_vector();
+    test_canonical();
+    test_arena();
+    test_scan();
+    test_incremental();
+    test_events();
+
+#ifdef PARSER_PROFILE_CHOICES
+    // only the addresses below are profiled
+    Impl::ChoiceProfile::Instance().Clear();
+#endif
     test_address("troll@bitch.com, arobar     d <sigma@addr.net>, sir john snow <user.name+tag+sorting@example.com(comment)>");
     test_address("arobar     d <sigma@addr.net>");
     test_address("troll@bitch.com");
@@ -101,5 +698,12 @@ int main(int argc, char ** argv)
     test_address("this\\ still\\\"not\\\\allowed@example.com");
     test_address("1234567890123456789012345678901234567890123456789012345678901234+x@example.com");
 
+#ifdef PARSER_PROFILE_CHOICES
+    // the addresses above are the training corpus of the order of the alternatives
+    std::ofstream choiceOrder("RFC5322ChoiceOrder.inl");
+    WriteChoiceOrder(choiceOrder, "RFC5322_ORDER_",
+        { "AText", "CText", "QText", "CContent", "QContent", "Word", "LocalPart", "Domain", "Mailbox", "Address" });
+#endif
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
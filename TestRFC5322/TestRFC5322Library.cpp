@@ -0,0 +1,28 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// parsing with the functions of the RFC5322Parser library: only its header is included, the grammar isn't
+
+#include <cassert>
+#include <sstream>
+
+#include "rfc5322/RFC5322Parser.hpp"
+
+void test_library()
+{
+    auto parser(Make_ParserFromString(std::string("John Doe <john@example.com>")));
+    MailboxData mailbox;
+    assert(RFC5322::ParseExact(parser, &mailbox));
+    assert(ToString(parser.OutputBuffer(), false, mailbox.NameAddr.Address.Content.DomainPart) == "example.com");
+
+    std::istringstream stream("a@b, c@d");
+    auto streamParser(Make_ParserFromStream(stream));
+    AddressListData addresses;
+    assert(RFC5322::ParseExact(streamParser, &addresses) && addresses.size() == 2);
+
+    auto invalidParser(Make_ParserFromString(std::string("no address")));
+    AddrSpecData addrSpec;
+    assert(false == RFC5322::ParseExact(invalidParser, &addrSpec));
+}
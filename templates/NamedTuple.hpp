@@ -10,6 +10,7 @@
 #include <string>
 #include <tuple>
 #include <sstream>
+#include <vector>
 
 namespace NamedTuple
 {
@@ -47,6 +48,28 @@ namespace std
 
 namespace NamedTuple
 {
+    // Recycle() of the named tuples: sets each member as Reset(), but the vectors are emptied in place so that they
+    // keep their capacity, and the nested named tuples are recycled too
+
+    template <typename TYPE, typename INITIAL, ENABLED_IF_NOT_VECTOR(TYPE)>
+    inline void Recycle(TYPE & that, INITIAL && initial)
+    {
+        that = initial();
+    }
+
+    template <typename LAST_MEMBER, typename INITIAL>
+    inline void Recycle(NamedTuple<LAST_MEMBER> & that, INITIAL &&)
+    {
+        that.Recycle();
+    }
+
+    template <typename VECTOR, typename INITIAL, ENABLED_IF_VECTOR(VECTOR)>
+    inline void Recycle(VECTOR & that, INITIAL && initial)
+    {
+        auto const & initialValue(initial());
+        that.assign(initialValue.begin(), initialValue.end());
+    }
+
 #define NAMEDTUPLE_BEGIN(name)                                               \
 namespace name##Members                                                      \
 {                                                                            \
@@ -71,6 +94,7 @@ namespace name##Members                                                      \
         inline std::tuple<> AsRTuple() const { return std::make_tuple();  }  \
         inline std::tuple<> AsRCTuple() const { return std::make_tuple();  } \
         inline void Reset() { }                                              \
+        inline void Recycle() { }                                            \
     };
 
 #define NAMEDTUPLE_ITEM_INTERNAL(ID, type, member, value, ...)                                                     \
@@ -114,6 +138,7 @@ namespace name##Members                                                      \
         inline auto AsRTuple() const { return std::tuple_cat(Base::AsRTuple(), std::tie((type const &)member));  } \
         inline auto AsRCTuple() const { return AsRTuple();  }                                                      \
         inline void Reset() { member.~type(); new (&member) type({ value }); Base::Reset(); }                      \
+        inline void Recycle() { ::NamedTuple::Recycle(member, [] { return type({ value }); }); Base::Recycle(); } \
     };
 
 #define NAMEDTUPLE_ITEM(type, member, value, ...) \
@@ -162,6 +187,12 @@ using name = NamedTuple::NamedTuple<name##Members::Member<__COUNTER__ - 1> >;
     template <typename LAST_MEMBER>
     class IsTuplish<::NamedTuple::NamedTuple<LAST_MEMBER> > : public std::true_type { };
 
+    template <typename MEMBER_CLASS, typename TYPE>
+    MEMBER_CLASS MemberClassOf(TYPE MEMBER_CLASS::*);
+
+    // Index of a member given by its name, e.g. NAMEDTUPLE_INDEX(AddrSpecData, DomainPart) for std::get<>()
+#define NAMEDTUPLE_INDEX(name, member) ((size_t)decltype(::NamedTuple::MemberClassOf(&name::member))::Index)
+
 #define ENABLED_IF_TUPLISH(which) std::enable_if_t<::NamedTuple::IsTuplish<which>::value, void *> = nullptr
 #define ENABLED_IF_NOT_TUPLISH(which) std::enable_if_t<!::NamedTuple::IsTuplish<which>::value, void *> = nullptr
 #define ENABLED_IF_TUPLISH_DEF(which) std::enable_if_t<::NamedTuple::IsTuplish<which>::value, void *> 
@@ -177,24 +208,24 @@ using name = NamedTuple::NamedTuple<name##Members::Member<__COUNTER__ - 1> >;
     };
 
 
-    template <typename MEMBER_INFO, typename MEMBER_VALUE, typename VISITOR>
+    template <typename MEMBER_INFO, typename MEMBER_VALUE, typename VISITOR, ENABLED_IF_NOT_VECTOR(MEMBER_VALUE)>
     inline void VisitNode(MEMBER_INFO const & memberInfo, MEMBER_VALUE const & memberValue, VISITOR && visitor)
     {
         visitor.OnMember(memberInfo, memberValue, [] { });
     }
 
-    template <typename MEMBER_INFO, typename TYPE, typename VISITOR>
-    inline void VisitNode(MEMBER_INFO const & memberInfo, std::vector<TYPE> const & memberValue, VISITOR && visitor);
+    template <typename MEMBER_INFO, typename VECTOR, typename VISITOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void VisitNode(MEMBER_INFO const & memberInfo, VECTOR const & that, VISITOR && visitor);
 
     template <typename MEMBER_INFO, typename LAST_MEMBER, typename VISITOR>
     inline void VisitNode(MEMBER_INFO const & memberInfo, NamedTuple<LAST_MEMBER> const & that, VISITOR && visitor);
 
-    template <typename MEMBER_INFO, typename TYPE, typename VISITOR>
-    inline void VisitNode(MEMBER_INFO const & memberInfo, std::vector<TYPE> const & that, VISITOR && visitor)
+    template <typename MEMBER_INFO, typename VECTOR, typename VISITOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline void VisitNode(MEMBER_INFO const & memberInfo, VECTOR const & that, VISITOR && visitor)
     {
         visitor.OnMember(memberInfo, that, [&]
         {
-            for (TYPE const & item : that)
+            for (auto const & item : that)
             {
                 VisitNode(memberInfo, item, std::forward<VISITOR>(visitor));
             }
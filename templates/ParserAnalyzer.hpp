@@ -0,0 +1,929 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// static analysis of the grammars: nullability, FIRST/FOLLOW sets and backtracking hazards
+#pragma once
+
+#include "ParserRegular.hpp"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Analysis of a grammar given by its rules (AnalyzeRule(AddressList())) or loaded from ABNF (rfc5234/ABNFAnalyzer.hpp).
+// Reports, for each rule, whether it matches empty, the characters it starts with and the ones that can follow it,
+// with the hazards found in its definition:
+// - LeftRecursion: the rule calls itself again before reading any character, the recursive engine never ends
+// - NullableRepeat: the element of a repetition matches empty, the repetition runs up to its maximum count
+//   without consuming anything (forever when unbounded)
+// - OverlappingAlternatives: several alternatives of a longest match choice start with the same characters,
+//   they all read the same input before the longest one is kept
+// - OverlappingFollow: an optional or repeated element can fail after having read characters that can start what
+//   follows it, these characters are read again
+// The cost is an estimate of the worst case number of times each input character is read by the expression.
+class GrammarAnalyzer
+{
+public:
+    using CharSet = std::bitset<256>;
+
+    enum : size_t
+    {
+        NoExpr = SIZE_MAX,
+        Unbounded = SIZE_MAX
+    };
+
+    class Expr
+    {
+    public:
+        enum Kinds
+        {
+            Empty,
+            Chars,
+            Sequence,
+            Choice,         // the longest match wins
+            FirstChoice,    // the first match wins
+            Repeat,
+            Predicate,
+            Cut,
+            Regular,        // matched by a DFA
+            RuleRef
+        };
+
+        Kinds Kind = Empty;
+        CharSet Set;
+        std::vector<size_t> Children;
+        size_t Min = 1;
+        size_t Max = 1;
+        std::string Name;               // rule name
+
+        bool Nullable = false;
+        CharSet First;
+        CharSet Follow;
+        size_t Cost = 0;
+    };
+
+    class Hazard
+    {
+    public:
+        enum Kinds
+        {
+            LeftRecursion,
+            NullableRepeat,
+            OverlappingAlternatives,
+            OverlappingFollow
+        };
+
+        Kinds Kind;
+        std::string Rule;
+        std::string Expression;
+        size_t Cost;
+        std::string Detail;
+
+        char const * KindName() const
+        {
+            static char const * const names[] = { "LeftRecursion", "NullableRepeat", "OverlappingAlternatives", "OverlappingFollow" };
+            return names[Kind];
+        }
+    };
+
+private:
+    std::vector<Expr> exprs_;
+    std::map<std::string, size_t> rules_;       // body of the rules, NoExpr while being described
+    std::vector<std::string> ruleOrder_;
+    std::vector<Hazard> hazards_;
+    bool changed_ = false;
+
+    static inline size_t AddCost(size_t cost1, size_t cost2)
+    {
+        return (cost1 == Unbounded || cost2 == Unbounded || cost1 + cost2 < cost1) ? (size_t)Unbounded : cost1 + cost2;
+    }
+
+    static inline size_t MulCost(size_t cost, size_t count)
+    {
+        return (cost == Unbounded || count == Unbounded || (cost != 0 && count > Unbounded / cost)) ? (size_t)Unbounded : cost * count;
+    }
+
+    size_t Add(Expr expr)
+    {
+        exprs_.push_back(std::move(expr));
+        return exprs_.size() - 1;
+    }
+
+    size_t Body(Expr const & expr) const
+    {
+        auto ruleEntryPtr(rules_.find(expr.Name));
+        return ruleEntryPtr != rules_.end() ? ruleEntryPtr->second : (size_t)NoExpr;
+    }
+
+    // Matches one character at most, so it can't fail after having read some input
+    bool SingleChar(size_t index, size_t depth = 0) const
+    {
+        enum { MaxDepth = 64 };
+        Expr const & expr(exprs_[index]);
+        if (depth > MaxDepth)
+            return false;
+        switch (expr.Kind)
+        {
+        case Expr::Chars:
+            return true;
+        case Expr::Choice:
+        case Expr::FirstChoice:
+            return std::all_of(expr.Children.begin(), expr.Children.end(), [&](size_t child) { return SingleChar(child, depth + 1); });
+        case Expr::Sequence:
+            return expr.Children.size() == 1 && SingleChar(expr.Children.front(), depth + 1);
+        case Expr::Repeat:
+            return expr.Max <= 1 && SingleChar(expr.Children.front(), depth + 1);
+        case Expr::RuleRef:
+            return Body(expr) != NoExpr && SingleChar(Body(expr), depth + 1);
+        default:
+            return false;
+        }
+    }
+
+    // Nullable and FIRST set of the expression from the ones of its children
+    void UpdateFirst(Expr & expr)
+    {
+        bool nullable(false);
+        CharSet first;
+        switch (expr.Kind)
+        {
+        case Expr::Empty:
+        case Expr::Predicate:
+        case Expr::Cut:
+            nullable = true;
+            break;
+        case Expr::Chars:
+            first = expr.Set;
+            break;
+        case Expr::Sequence:
+            nullable = true;
+            for (auto child : expr.Children)
+            {
+                first |= exprs_[child].First;
+                if (!exprs_[child].Nullable)
+                {
+                    nullable = false;
+                    break;
+                }
+            }
+            break;
+        case Expr::Choice:
+        case Expr::FirstChoice:
+            for (auto child : expr.Children)
+            {
+                first |= exprs_[child].First;
+                nullable = nullable || exprs_[child].Nullable;
+            }
+            break;
+        case Expr::Repeat:
+            nullable = expr.Min == 0 || exprs_[expr.Children.front()].Nullable;
+            if (expr.Max > 0)
+                first = exprs_[expr.Children.front()].First;
+            break;
+        case Expr::Regular:
+            nullable = exprs_[expr.Children.front()].Nullable;
+            first = exprs_[expr.Children.front()].First;
+            break;
+        case Expr::RuleRef:
+            if (Body(expr) != NoExpr)
+            {
+                nullable = exprs_[Body(expr)].Nullable;
+                first = exprs_[Body(expr)].First;
+            }
+            break;
+        }
+        if (nullable != expr.Nullable || first != expr.First)
+        {
+            expr.Nullable = nullable;
+            expr.First = first;
+            changed_ = true;
+        }
+    }
+
+    void AddFollow(size_t index, CharSet const & follow)
+    {
+        if ((exprs_[index].Follow | follow) != exprs_[index].Follow)
+        {
+            exprs_[index].Follow |= follow;
+            changed_ = true;
+        }
+    }
+
+    // Pass what can follow the expression down to its children, and to the body of the rules it references
+    void UpdateFollow(size_t index)
+    {
+        Expr const & expr(exprs_[index]);
+        switch (expr.Kind)
+        {
+        case Expr::Sequence:
+        {
+            CharSet follow(expr.Follow);
+            for (auto childPtr = expr.Children.rbegin(); childPtr != expr.Children.rend(); ++childPtr)
+            {
+                AddFollow(*childPtr, follow);
+                UpdateFollow(*childPtr);
+                follow = exprs_[*childPtr].Nullable ? (exprs_[*childPtr].First | follow) : exprs_[*childPtr].First;
+            }
+            break;
+        }
+        case Expr::Choice:
+        case Expr::FirstChoice:
+        case Expr::Predicate:
+        case Expr::Regular:
+            for (auto child : expr.Children)
+            {
+                AddFollow(child, expr.Follow);
+                UpdateFollow(child);
+            }
+            break;
+        case Expr::Repeat:
+        {
+            size_t elem(expr.Children.front());
+            AddFollow(elem, expr.Max > 1 ? (expr.Follow | exprs_[elem].First) : expr.Follow);
+            UpdateFollow(elem);
+            break;
+        }
+        case Expr::RuleRef:
+            if (Body(expr) != NoExpr)
+                AddFollow(Body(expr), expr.Follow);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // An optional or repeated element read again by what follows when it fails
+    bool Speculative(size_t index, CharSet const & follow) const
+    {
+        Expr const & expr(exprs_[index]);
+        if (expr.Kind == Expr::Predicate)
+            return (exprs_[expr.Children.front()].First & follow).any();
+        return expr.Kind == Expr::Repeat && expr.Min < expr.Max && !SingleChar(expr.Children.front()) &&
+            (exprs_[expr.Children.front()].First & follow).any();
+    }
+
+    // Cost of reading the character when the expression starts with it: what a failed attempt costs when it stops
+    // right after
+    size_t LeadingCost(size_t index, size_t ch, size_t depth = 0) const
+    {
+        enum { MaxDepth = 16 };
+        Expr const & expr(exprs_[index]);
+        if (!expr.First[ch])
+            return 0;
+        if (depth > MaxDepth)
+            return expr.Cost;
+        switch (expr.Kind)
+        {
+        case Expr::Sequence:
+        {
+            size_t cost(0);
+            for (auto child : expr.Children)
+            {
+                cost = std::max(cost, LeadingCost(child, ch, depth + 1));
+                if (!exprs_[child].Nullable)
+                    break;
+            }
+            return cost;
+        }
+        case Expr::Choice:
+        case Expr::FirstChoice:
+        {
+            size_t cost(0);
+            for (auto child : expr.Children)
+                cost = AddCost(cost, LeadingCost(child, ch, depth + 1));
+            return cost;
+        }
+        case Expr::Repeat:
+        case Expr::Predicate:
+            return LeadingCost(expr.Children.front(), ch, depth + 1);
+        case Expr::RuleRef:
+            return Body(expr) != NoExpr ? LeadingCost(Body(expr), ch, depth + 1) : 1;
+        default:
+            return 1;
+        }
+    }
+
+    // Alternatives starting with the given character
+    template <typename FUNC>
+    void ForEachOverlap(Expr const & expr, FUNC && func) const
+    {
+        for (size_t ch = 0; ch < 256; ++ch)
+        {
+            size_t count(0);
+            size_t cost(0);
+            for (auto child : expr.Children)
+            {
+                if (exprs_[child].First[ch])
+                {
+                    ++count;
+                    cost = AddCost(cost, exprs_[child].Cost);
+                }
+            }
+            func(ch, count, cost);
+        }
+    }
+
+    size_t ComputeCost(Expr const & expr) const
+    {
+        switch (expr.Kind)
+        {
+        case Expr::Chars:
+            return 1;
+        case Expr::Regular:
+            return 1;
+        case Expr::Predicate:
+            return exprs_[expr.Children.front()].Cost;
+        case Expr::Sequence:
+        {
+            // Each character is read by one element, and again by the next ones after a speculative element failed
+            size_t cost(0);
+            for (size_t index = 0; index < expr.Children.size(); ++index)
+            {
+                size_t childCost(exprs_[expr.Children[index]].Cost);
+                CharSet follow;
+                size_t next(index + 1);
+                for (; next < expr.Children.size(); ++next)
+                {
+                    follow |= exprs_[expr.Children[next]].First;
+                    if (!exprs_[expr.Children[next]].Nullable)
+                        break;
+                }
+                if (Speculative(expr.Children[index], follow))
+                {
+                    CharSet overlap(exprs_[expr.Children[index]].First & follow);
+                    for (size_t ch = 0; ch < 256; ++ch)
+                    {
+                        if (!overlap[ch])
+                            continue;
+                        size_t followCost(0);
+                        for (size_t followIndex = index + 1; followIndex <= next && followIndex < expr.Children.size(); ++followIndex)
+                            followCost = std::max(followCost, LeadingCost(expr.Children[followIndex], ch));
+                        childCost = std::max(childCost, AddCost(LeadingCost(expr.Children[index], ch), followCost));
+                    }
+                }
+                cost = std::max(cost, childCost);
+            }
+            return cost;
+        }
+        case Expr::Choice:
+        case Expr::FirstChoice:
+        {
+            // All the alternatives starting with a character read it
+            size_t cost(0);
+            for (auto child : expr.Children)
+                cost = std::max(cost, exprs_[child].Cost);
+            ForEachOverlap(expr, [&](size_t, size_t, size_t overlapCost) { cost = std::max(cost, overlapCost); });
+            return cost;
+        }
+        case Expr::Repeat:
+        {
+            Expr const & elem(exprs_[expr.Children.front()]);
+            if (expr.Max > 1 && elem.Nullable)
+                return expr.Max == SIZE_MAX ? (size_t)Unbounded : MulCost(std::max(elem.Cost, (size_t)1), expr.Max);
+            return elem.Cost;
+        }
+        case Expr::RuleRef:
+            return Body(expr) != NoExpr ? exprs_[Body(expr)].Cost : 1;
+        default:
+            return 0;
+        }
+    }
+
+    void UpdateCost(Expr & expr)
+    {
+        size_t cost(ComputeCost(expr));
+        if (cost != expr.Cost)
+        {
+            expr.Cost = cost;
+            changed_ = true;
+        }
+    }
+
+    void AddHazard(Hazard::Kinds kind, std::string const & rule, size_t index, size_t cost, std::string detail)
+    {
+        hazards_.push_back({ kind, rule, ToString(index), cost, std::move(detail) });
+    }
+
+    // Whether the expression can call the rule before reading any character, path gives the rules called in between
+    bool LeftRecursive(size_t index, std::string const & rule, std::vector<std::string> & path, std::set<std::string> & visited) const
+    {
+        Expr const & expr(exprs_[index]);
+        switch (expr.Kind)
+        {
+        case Expr::Sequence:
+            for (auto child : expr.Children)
+            {
+                if (LeftRecursive(child, rule, path, visited))
+                    return true;
+                if (!exprs_[child].Nullable)
+                    break;
+            }
+            return false;
+        case Expr::Choice:
+        case Expr::FirstChoice:
+        case Expr::Repeat:
+        case Expr::Predicate:
+        case Expr::Regular:
+            return std::any_of(expr.Children.begin(), expr.Children.end(),
+                [&](size_t child) { return LeftRecursive(child, rule, path, visited); });
+        case Expr::RuleRef:
+            if (expr.Name == rule)
+                return true;
+            if (Body(expr) == NoExpr || !visited.insert(expr.Name).second)
+                return false;
+            path.push_back(expr.Name);
+            if (LeftRecursive(Body(expr), rule, path, visited))
+                return true;
+            path.pop_back();
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    void FindLeftRecursion(std::string const & rule, size_t index)
+    {
+        std::vector<std::string> path;
+        std::set<std::string> visited;
+        if (LeftRecursive(index, rule, path, visited))
+        {
+            std::string detail("the rule calls itself before reading any character");
+            for (auto const & ruleName : path)
+                detail += (&ruleName == &path.front() ? " through " : ", ") + ruleName;
+            AddHazard(Hazard::LeftRecursion, rule, index, Unbounded, std::move(detail));
+        }
+    }
+
+    void FindHazards(std::string const & rule, size_t index)
+    {
+        Expr const & expr(exprs_[index]);
+        switch (expr.Kind)
+        {
+        case Expr::Choice:
+        {
+            size_t worstCount(0);
+            CharSet worstChars;
+            ForEachOverlap(expr, [&](size_t ch, size_t count, size_t)
+            {
+                if (count > worstCount)
+                {
+                    worstCount = count;
+                    worstChars.reset();
+                }
+                if (count == worstCount)
+                    worstChars.set(ch);
+            });
+            if (worstCount > 1)
+            {
+                AddHazard(Hazard::OverlappingAlternatives, rule, index, expr.Cost,
+                    std::to_string(worstCount) + " alternatives start with " + ToString(worstChars));
+            }
+            break;
+        }
+        case Expr::Repeat:
+        {
+            Expr const & elem(exprs_[expr.Children.front()]);
+            if (expr.Max > 1 && elem.Nullable)
+            {
+                AddHazard(Hazard::NullableRepeat, rule, index, expr.Cost,
+                    expr.Max == SIZE_MAX ? "the element matches empty, the repetition never ends" : "the element matches empty");
+            }
+            else if (expr.Min < expr.Max && !SingleChar(expr.Children.front()) && (elem.First & expr.Follow).any())
+            {
+                CharSet overlap(elem.First & expr.Follow);
+                size_t cost(0);
+                for (size_t ch = 0; ch < 256; ++ch)
+                {
+                    if (overlap[ch])
+                        cost = std::max(cost, LeadingCost(index, ch));
+                }
+                AddHazard(Hazard::OverlappingFollow, rule, index, cost, "a failed element is read again from " + ToString(overlap));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        // Regular expressions are run by a DFA, rules are checked on their own
+        if (expr.Kind != Expr::Regular && expr.Kind != Expr::RuleRef)
+        {
+            for (auto child : expr.Children)
+                FindHazards(rule, child);
+        }
+    }
+
+public:
+    // Building of the grammar, by Describe(grammar, primitive) for the rules
+
+    size_t Empty()
+    {
+        return Add(Expr());
+    }
+
+    size_t Chars(CharSet const & set)
+    {
+        Expr expr;
+        expr.Kind = Expr::Chars;
+        expr.Set = set;
+        return Add(std::move(expr));
+    }
+
+    // NoExpr children (ie. indices in the rules) are ignored
+    size_t Sequence(std::vector<size_t> children, Expr::Kinds kind = Expr::Sequence)
+    {
+        Expr expr;
+        expr.Kind = kind;
+        std::copy_if(children.begin(), children.end(), std::back_inserter(expr.Children), [](size_t child) { return child != NoExpr; });
+        return Add(std::move(expr));
+    }
+
+    size_t Choice(std::vector<size_t> children, bool firstMatch = false)
+    {
+        return Sequence(std::move(children), firstMatch ? Expr::FirstChoice : Expr::Choice);
+    }
+
+    size_t Repeat(size_t minCount, size_t maxCount, size_t elem)
+    {
+        Expr expr;
+        expr.Kind = Expr::Repeat;
+        expr.Min = minCount;
+        expr.Max = maxCount;
+        expr.Children.push_back(elem);
+        return Add(std::move(expr));
+    }
+
+    size_t Predicate(bool expected, size_t elem)
+    {
+        Expr expr;
+        expr.Kind = Expr::Predicate;
+        expr.Min = expected ? 1 : 0;
+        expr.Children.push_back(elem);
+        return Add(std::move(expr));
+    }
+
+    size_t Cut()
+    {
+        Expr expr;
+        expr.Kind = Expr::Cut;
+        return Add(std::move(expr));
+    }
+
+    size_t Regular(size_t elem)
+    {
+        Expr expr;
+        expr.Kind = Expr::Regular;
+        expr.Children.push_back(elem);
+        return Add(std::move(expr));
+    }
+
+    // Keep the first match of a choice
+    size_t FirstMatch(size_t choice)
+    {
+        if (exprs_[choice].Kind == Expr::Choice)
+            exprs_[choice].Kind = Expr::FirstChoice;
+        return choice;
+    }
+
+    // Returns true if the rule is new, its body is then given by DefineRule()
+    bool DeclareRule(std::string const & name)
+    {
+        if (rules_.find(name) != rules_.end())
+            return false;
+        rules_[name] = NoExpr;
+        ruleOrder_.push_back(name);
+        return true;
+    }
+
+    void DefineRule(std::string const & name, size_t body)
+    {
+        rules_[name] = body;
+    }
+
+    size_t RuleRef(std::string const & name)
+    {
+        Expr expr;
+        expr.Kind = Expr::RuleRef;
+        expr.Name = name;
+        return Add(std::move(expr));
+    }
+
+    // Fixed points of the nullability and FIRST sets, then FOLLOW sets and costs, then the hazards
+    void Analyze()
+    {
+        do
+        {
+            changed_ = false;
+            for (auto & expr : exprs_)
+                UpdateFirst(expr);
+        } while (changed_);
+
+        do
+        {
+            changed_ = false;
+            for (auto const & rule : rules_)
+            {
+                if (rule.second != NoExpr)
+                    UpdateFollow(rule.second);
+            }
+        } while (changed_);
+
+        // Costs only grow: still growing after a pass per rule, they grow with the nesting of the rules
+        for (auto & expr : exprs_)
+            expr.Cost = 0;
+        size_t passes(0);
+        do
+        {
+            changed_ = false;
+            for (auto & expr : exprs_)
+                UpdateCost(expr);
+            if (changed_ && ++passes > rules_.size() + 2)
+            {
+                for (auto & expr : exprs_)
+                {
+                    size_t cost(ComputeCost(expr));
+                    if (cost != expr.Cost)
+                        expr.Cost = Unbounded;
+                }
+            }
+        } while (changed_);
+
+        hazards_.clear();
+        for (auto const & ruleName : ruleOrder_)
+        {
+            if (rules_[ruleName] != NoExpr)
+            {
+                FindLeftRecursion(ruleName, rules_[ruleName]);
+                FindHazards(ruleName, rules_[ruleName]);
+            }
+        }
+    }
+
+    std::vector<std::string> const & Rules() const
+    {
+        return ruleOrder_;
+    }
+
+    // Body of the rule, NoExpr if unknown
+    size_t Rule(std::string const & name) const
+    {
+        auto ruleEntryPtr(rules_.find(name));
+        return ruleEntryPtr != rules_.end() ? ruleEntryPtr->second : (size_t)NoExpr;
+    }
+
+    Expr const & operator[](size_t index) const
+    {
+        return exprs_[index];
+    }
+
+    std::vector<Hazard> const & Hazards() const
+    {
+        return hazards_;
+    }
+
+    static std::string ToString(CharSet const & set)
+    {
+        std::stringstream ss;
+        auto put = [&](size_t ch)
+        {
+            if (ch > 0x20 && ch < 0x7F && ch != '\\' && ch != '-' && ch != ']')
+                ss << (char)ch;
+            else
+                ss << "\\x" << std::hex << std::setw(2) << std::setfill('0') << ch << std::dec;
+        };
+        ss << "[";
+        for (size_t ch = 0; ch < 256; ++ch)
+        {
+            if (!set[ch])
+                continue;
+            size_t last(ch);
+            while (last + 1 < 256 && set[last + 1])
+                ++last;
+            put(ch);
+            if (last > ch + 1)
+                ss << "-";
+            if (last > ch)
+                put(last);
+            ch = last;
+        }
+        ss << "]";
+        return ss.str();
+    }
+
+    // The expression written with the primitives
+    std::string ToString(size_t index) const
+    {
+        Expr const & expr(exprs_[index]);
+        auto children = [&]
+        {
+            std::string str;
+            for (auto child : expr.Children)
+                str += (str.empty() ? "" : ", ") + ToString(child);
+            return str;
+        };
+        switch (expr.Kind)
+        {
+        case Expr::Chars:
+            return ToString(expr.Set);
+        case Expr::Sequence:
+        {
+            // Literals, case insensitive ones in lower case
+            std::string literal;
+            for (auto child : expr.Children)
+            {
+                CharSet const & set(exprs_[child].Set);
+                size_t ch(0);
+                while (ch < 256 && !set[ch])
+                    ++ch;
+                if (exprs_[child].Kind != Expr::Chars || ch < 0x20 || ch >= 0x7F || ch == '\"' ||
+                    !(set.count() == 1 || (set.count() == 2 && std::isupper((int)ch) && set[ch ^ 0x20])))
+                {
+                    literal.clear();
+                    break;
+                }
+                literal.push_back((char)(set.count() == 2 ? ch ^ 0x20 : ch));
+            }
+            if (expr.Children.size() > 1 && !literal.empty())
+                return "\"" + literal + "\"";
+            return "Sequence(" + children() + ")";
+        }
+        case Expr::Choice:
+            return "Alternatives(" + children() + ")";
+        case Expr::FirstChoice:
+            return "PreferFirst(" + children() + ")";
+        case Expr::Repeat:
+            if (expr.Min == 0 && expr.Max == 1)
+                return "Optional(" + children() + ")";
+            if (expr.Max == SIZE_MAX)
+                return (expr.Min == 0 ? std::string("Repeat(") : "Repeat<" + std::to_string(expr.Min) + ">(") + children() + ")";
+            return "Repeat<" + std::to_string(expr.Min) + ", " + std::to_string(expr.Max) + ">(" + children() + ")";
+        case Expr::Predicate:
+            return (expr.Min ? "And(" : "Not(") + children() + ")";
+        case Expr::Cut:
+            return "Cut()";
+        case Expr::Regular:
+            return "Regular(" + children() + ")";
+        case Expr::RuleRef:
+            return expr.Name;
+        default:
+            return "Empty()";
+        }
+    }
+
+    static std::string CostToString(size_t cost)
+    {
+        return cost == Unbounded ? "unbounded" : std::to_string(cost);
+    }
+
+    // One line per rule, followed by its hazards
+    void Report(std::ostream & os) const
+    {
+        for (auto const & ruleName : ruleOrder_)
+        {
+            size_t body(Rule(ruleName));
+            if (body == NoExpr)
+            {
+                os << ruleName << ": undefined" << std::endl;
+                continue;
+            }
+            Expr const & expr(exprs_[body]);
+            os << ruleName << ":" << (expr.Nullable ? " nullable," : "") << " first " << ToString(expr.First)
+                << ", follow " << ToString(expr.Follow) << ", cost " << CostToString(expr.Cost) << std::endl;
+            for (auto const & hazard : hazards_)
+            {
+                if (hazard.Rule == ruleName)
+                {
+                    os << "    " << hazard.KindName() << " (cost " << CostToString(hazard.Cost) << "): "
+                        << hazard.Expression << ": " << hazard.Detail << std::endl;
+                }
+            }
+        }
+    }
+};
+
+// Description of the primitives in the analyzer, NoExpr for the indices
+
+template <typename GRAMMAR, size_t INDEX>
+inline size_t Describe(GRAMMAR & grammar, Idx<INDEX>)
+{
+    return GRAMMAR::NoExpr;
+}
+
+template <typename GRAMMAR, MaxCharType... CODES>
+inline size_t Describe(GRAMMAR & grammar, CharVal<CODES...>)
+{
+    typename GRAMMAR::CharSet chars;
+    for (MaxCharType code : { CODES... })
+    {
+        if (code >= 0 && code <= 0xFF)
+            chars.set((size_t)code);
+    }
+    return grammar.Chars(chars);
+}
+
+template <typename GRAMMAR, MaxCharType CH1, MaxCharType CH2>
+inline size_t Describe(GRAMMAR & grammar, CharRange<CH1, CH2>)
+{
+    typename GRAMMAR::CharSet chars;
+    for (MaxCharType code = std::max(CH1, (MaxCharType)0); code <= CH2 && code <= 0xFF; ++code)
+        chars.set((size_t)code);
+    return grammar.Chars(chars);
+}
+
+template <typename GRAMMAR, MaxCharType... CODES>
+inline size_t Describe(GRAMMAR & grammar, Literal<CODES...>)
+{
+    std::vector<size_t> chars;
+    for (MaxCharType code : { CODES... })
+        chars.push_back(grammar.Chars(typename GRAMMAR::CharSet().set((size_t)code & 0xFF)));
+    return grammar.Sequence(chars);
+}
+
+template <typename GRAMMAR, MaxCharType... CODES>
+inline size_t Describe(GRAMMAR & grammar, ILiteral<CODES...>)
+{
+    std::vector<size_t> chars;
+    for (MaxCharType code : { CODES... })
+    {
+        chars.push_back(grammar.Chars(typename GRAMMAR::CharSet()
+            .set((size_t)code & 0xFF).set((size_t)(code ^ Impl::CaseFoldMask(code)) & 0xFF)));
+    }
+    return grammar.Sequence(chars);
+}
+
+template <typename GRAMMAR, typename PRIMITIVE>
+inline size_t Describe(GRAMMAR & grammar, RegularType<PRIMITIVE> const & what)
+{
+    return grammar.Regular(Describe(grammar, what.Elem()));
+}
+
+template <typename GRAMMAR, bool FIRST_MATCH, typename CHOICE, size_t... ORDER>
+inline size_t Describe(GRAMMAR & grammar, PreferType<FIRST_MATCH, CHOICE, ORDER...> const & what)
+{
+    size_t choice(Describe(grammar, what.Elem()));
+    return FIRST_MATCH ? grammar.FirstMatch(choice) : choice;
+}
+
+template <typename GRAMMAR, bool EXPECTED, typename PRIMITIVE>
+inline size_t Describe(GRAMMAR & grammar, PredicateType<EXPECTED, PRIMITIVE> const & what)
+{
+    return grammar.Predicate(EXPECTED, Describe(grammar, what.Elem()));
+}
+
+template <typename GRAMMAR>
+inline size_t Describe(GRAMMAR & grammar, CutType const &)
+{
+    return grammar.Cut();
+}
+
+template <typename GRAMMAR, typename PRIMITIVE>
+inline size_t Describe(GRAMMAR & grammar, SkipType<PRIMITIVE> const & what)
+{
+    return Describe(grammar, what.Elem());
+}
+
+template <typename GRAMMAR, typename PRIMITIVE>
+inline size_t Describe(GRAMMAR & grammar, NoCaptureType<PRIMITIVE> const & what)
+{
+    return Describe(grammar, what.Elem());
+}
+
+template <typename GRAMMAR, size_t MIN_COUNT, size_t MAX_COUNT, typename PRIMITIVE>
+inline size_t Describe(GRAMMAR & grammar, RepeatType<MIN_COUNT, MAX_COUNT, PRIMITIVE> const & what)
+{
+    return grammar.Repeat(MIN_COUNT, MAX_COUNT, Describe(grammar, what.Elem()));
+}
+
+namespace Impl
+{
+    template <typename GRAMMAR, typename SEQ_TYPE, typename... PRIMITIVES, size_t... POSITIONS>
+    inline size_t DescribeItems(GRAMMAR & grammar, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what, std::index_sequence<POSITIONS...>)
+    {
+        std::vector<size_t> children({ GRAMMAR::NoExpr, Describe(grammar, std::get<POSITIONS>(what.Primitives()))... });
+        return std::is_same<SEQ_TYPE, SeqTypeSeq>::value ? grammar.Sequence(children) : grammar.Choice(children);
+    }
+}
+
+template <typename GRAMMAR, typename SEQ_TYPE, typename... PRIMITIVES>
+inline size_t Describe(GRAMMAR & grammar, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what)
+{
+    return Impl::DescribeItems(grammar, what, std::index_sequence_for<PRIMITIVES...>());
+}
+
+// Analysis of the rule and of the rules it uses
+template <typename RULE>
+inline GrammarAnalyzer AnalyzeRule(RULE const & rule)
+{
+    GrammarAnalyzer grammar;
+    Describe(grammar, rule);
+    grammar.Analyze();
+    return grammar;
+}
@@ -0,0 +1,98 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// arena allocation of the parsed data: everything allocated while parsing many inputs is freed at once
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Monotonic memory: each allocation takes the next bytes of the current chunk, nothing is freed before Reset().
+// Reset() keeps the chunks for the next inputs, so that parsing in a loop stops allocating once they are big enough.
+// Given to a parser, e.g. Make_ParserFromString(text, &arena), and to its data, Make_Data<AddressListData>(&arena).
+// Not thread safe: the threads parsing at the same time each use their own arena.
+class Arena : public std::pmr::memory_resource
+{
+    class Chunk
+    {
+    public:
+        std::unique_ptr<char[]> Memory;
+        size_t Size;
+    };
+
+    std::vector<Chunk> chunks_;
+    size_t chunkIndex_;     // chunk being used, chunks_.size() if none yet
+    size_t chunkPos_;
+    size_t chunkSize_;
+    size_t used_;
+
+    inline void * do_allocate(size_t size, size_t alignment) override
+    {
+        for (; chunkIndex_ < chunks_.size(); ++chunkIndex_, chunkPos_ = 0)
+        {
+            Chunk & chunk(chunks_[chunkIndex_]);
+            size_t pos((chunkPos_ + alignment - 1) & ~(alignment - 1));
+            if (pos <= chunk.Size && size <= chunk.Size - pos)
+            {
+                chunkPos_ = pos + size;
+                used_ += size;
+                return chunk.Memory.get() + pos;
+            }
+        }
+
+        // the memory of new[] is aligned for any fundamental type, and bigger requests get their own chunk
+        size_t newSize(std::max(chunkSize_, size));
+        chunks_.push_back({ std::unique_ptr<char[]>(new char[newSize]), newSize });
+        chunkIndex_ = chunks_.size() - 1;
+        chunkPos_ = size;
+        used_ += size;
+        return chunks_.back().Memory.get();
+    }
+
+    inline void do_deallocate(void *, size_t, size_t) override
+    {
+    }
+
+    inline bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    inline explicit Arena(size_t chunkSize = 64 * 1024)
+        : chunkIndex_(0), chunkPos_(0), chunkSize_(chunkSize), used_(0)
+    {
+    }
+
+    Arena(Arena const &) = delete;
+    Arena & operator=(Arena const &) = delete;
+
+    // Everything allocated before is freed, the containers using it must not be used anymore
+    inline void Reset()
+    {
+        chunkIndex_ = 0;
+        chunkPos_ = 0;
+        used_ = 0;
+    }
+
+    // Bytes allocated since the last Reset()
+    inline size_t Used() const
+    {
+        return used_;
+    }
+
+    inline size_t Reserved() const
+    {
+        size_t reserved(0);
+        for (Chunk const & chunk : chunks_)
+        {
+            reserved += chunk.Size;
+        }
+        return reserved;
+    }
+};
@@ -10,6 +10,9 @@
 #include <string>
 #include <cstdint>
 #include <vector>
+#include <memory_resource>
+#include <new>
+#include <string_view>
 #include <cassert>
 #include <algorithm>
 #include <type_traits>
@@ -28,6 +31,25 @@
 #define CONSTANT_F(funcname, ...) std::remove_reference_t<decltype(funcname(std::declval<__VA_ARGS__>()))>::value
 #define TYPE_F(funcname, ...) typename std::remove_reference_t<decltype(funcname(std::declval<__VA_ARGS__>()))>
 
+#include "ParserSmallVector.hpp"
+
+namespace Impl
+{
+    // Also matches classes deriving from std::vector (ie. ConcatenationData), whatever their allocator
+    template <typename ELEM, typename ALLOCATOR>
+    std::true_type IsVector(std::vector<ELEM, ALLOCATOR> const *);
+
+    template <typename ELEM, size_t INLINE_COUNT, typename ALLOCATOR>
+    std::true_type IsVector(SmallVector<ELEM, INLINE_COUNT, ALLOCATOR> const *);
+
+    std::false_type IsVector(void const *);
+}
+
+// The vectors and the SmallVectors of the data share the same overloads
+#define ENABLED_IF_VECTOR(which) ENABLED_IF(CONSTANT_F(::Impl::IsVector, which const *))
+#define ENABLED_IF_NOT_VECTOR(which) ENABLED_IF(!CONSTANT_F(::Impl::IsVector, which const *))
+#define ENABLED_IF_VECTOR_DEF(which) ENABLED_IF_DEF(CONSTANT_F(::Impl::IsVector, which const *))
+
 #include "NamedTuple.hpp"
 
 template <size_t N>
@@ -40,14 +62,95 @@ using MaxCharType = int;
 
 using SubstringPos = std::pair<size_t, size_t>;
 
-template <typename CHAR_TYPE>
-inline std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE> const & buffer, SubstringPos subString)
+// Vector of the parsed data and of the parser buffers. The memory comes from the memory resource given to its
+// constructor, the default one (the heap) if none: the parsers use the one they are made with, see Make_Data().
+template <typename TYPE>
+using ParserVector = std::vector<TYPE, std::pmr::polymorphic_allocator<TYPE> >;
+
+// For the lists that are usually short, the first INLINE_COUNT elements don't allocate
+template <typename TYPE, size_t INLINE_COUNT>
+using ParserSmallVector = SmallVector<TYPE, INLINE_COUNT, std::pmr::polymorphic_allocator<TYPE> >;
+
+namespace Impl
+{
+    // Same as data = {}, the vectors and the ones of the named tuples keep their capacity, see NamedTuple::Recycle()
+    template <typename TYPE>
+    inline void ResetData(TYPE & data)
+    {
+        NamedTuple::Recycle(data, [] { return TYPE(); });
+    }
+
+    template <typename FUNC, size_t... INDICES>
+    inline void ForEachIndex(FUNC && func, std::index_sequence<INDICES...>)
+    {
+        bool const called[] = { true, (func(Idx<INDICES>()), true)... };
+        (void)called;
+    }
+
+    // Calls func(Idx<INDEX>()) for each member of the tuple or named tuple type, in order
+    template <typename TUPLE_TYPE, typename FUNC, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void ForEachIndex(FUNC && func)
+    {
+        ForEachIndex(func, std::make_index_sequence<std::tuple_size<TUPLE_TYPE>::value>());
+    }
+
+    // The vectors with a std::pmr allocator
+    template <typename TYPE>
+    std::true_type HasResource(TYPE const *, decltype(std::declval<TYPE const &>().get_allocator().resource()) = nullptr);
+
+    std::false_type HasResource(void const *);
+
+    template <typename TYPE, ENABLED_IF(!CONSTANT_F(HasResource, TYPE const *) && !::NamedTuple::IsTuplish<TYPE>::value)>
+    inline void UseResource(TYPE & /* data */, std::pmr::memory_resource * /* resource */)
+    {
+    }
+
+    // An allocator can't be changed: the empty vector is constructed again with the resource
+    template <typename VECTOR, ENABLED_IF(CONSTANT_F(HasResource, VECTOR const *))>
+    inline void UseResource(VECTOR & data, std::pmr::memory_resource * resource)
+    {
+        if (data.get_allocator().resource() != resource)
+        {
+            assert(data.empty());
+            data.~VECTOR();
+            new (&data) VECTOR(typename VECTOR::allocator_type(resource));
+        }
+    }
+
+    template <typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void UseResource(TUPLE_TYPE & data, std::pmr::memory_resource * resource)
+    {
+        ForEachIndex<TUPLE_TYPE>([&](auto index) { UseResource(std::get<decltype(index)::value>(data), resource); });
+    }
+}
+
+// Empty data whose vectors, and the ones of its named tuples, allocate from resource. The parsers build their
+// temporary data from their own resource, the data given to them should be too: Make_Data<MailboxData>(&arena)
+template <typename TYPE>
+inline TYPE Make_Data(std::pmr::memory_resource * resource)
+{
+    TYPE data = {};
+    Impl::UseResource(data, resource);
+    return data;
+}
+
+template <typename CHAR_TYPE, typename ALLOCATOR>
+inline std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE, ALLOCATOR> const & buffer, SubstringPos subString)
 {
     subString.first = std::min(subString.first, buffer.size());
     subString.second = std::max(subString.first, std::min(subString.second, buffer.size()));
     return std::basic_string<CHAR_TYPE>(buffer.data() + subString.first, buffer.data() + subString.second);
 }
 
+// Same as ToString() without copy, valid until the buffer changes
+template <typename CHAR_TYPE, typename ALLOCATOR>
+inline std::basic_string_view<CHAR_TYPE> ToStringView(std::vector<CHAR_TYPE, ALLOCATOR> const & buffer, SubstringPos subString)
+{
+    subString.first = std::min(subString.first, buffer.size());
+    subString.second = std::max(subString.first, std::min(subString.second, buffer.size()));
+    return std::basic_string_view<CHAR_TYPE>(buffer.data() + subString.first, subString.second - subString.first);
+}
+
 inline bool IsEmpty(SubstringPos const & sub)
 {
     return sub.second <= sub.first;
@@ -58,8 +161,8 @@ inline bool IsEmpty(std::nullptr_t)
     return true;
 }
 
-template <typename ELEM>
-inline bool IsEmpty(std::vector<ELEM> const & arr);
+template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+inline bool IsEmpty(VECTOR const & arr);
 
 template <size_t OFFSET, typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
 inline bool IsEmpty(TUPLE_TYPE const & tuple);
@@ -81,8 +184,8 @@ inline bool IsEmpty(TUPLE_TYPE const & tuple)
     return true;
 }
 
-template <typename ELEM>
-inline bool IsEmpty(std::vector<ELEM> const & arr)
+template <typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+inline bool IsEmpty(VECTOR const & arr)
 {
     for (auto const & elem : arr)
     {
@@ -102,8 +205,8 @@ inline bool IsNull(std::nullptr_t)
     return true;
 }
 
-template <typename ELEM>
-inline bool IsNull(std::vector<ELEM> const & arr);
+template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+inline bool IsNull(VECTOR const & arr);
 
 template <size_t OFFSET, typename... ARGS>
 inline bool IsNull(std::tuple<ARGS...> const & tuple);
@@ -125,8 +228,8 @@ inline bool IsNull(std::tuple<ARGS...> const & tuple)
     return true;
 }
 
-template <typename ELEM>
-inline bool IsNull(std::vector<ELEM> const & arr)
+template <typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+inline bool IsNull(VECTOR const & arr)
 {
     for (auto const & elem : arr)
     {
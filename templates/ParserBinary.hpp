@@ -0,0 +1,279 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// compact binary form of the parsed data with its output buffer, read back without parsing again
+#pragma once
+
+#include "ParserBase.hpp"
+
+#include <cstring>
+
+// The data is written member by member, the vectors prefixed by their size, then the output buffer up to the last
+// position used. Integers are varints, each position is the zigzag delta from the end of the previous one, so that
+// the consecutive parts of the data take a byte or two:
+//   position: 0 for a null one, else zigzag(first - previous end) + 1, then zigzag(second - first)
+//   buffer:   count, then the characters (raw bytes for char, varints for the wider ones)
+
+namespace Impl
+{
+    inline uint64_t ZigZag(int64_t value)
+    {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    class BinaryWriter
+    {
+        std::vector<uint8_t> & bytes_;
+        size_t lastPos_;
+        size_t maxPos_;
+    public:
+        inline BinaryWriter(std::vector<uint8_t> & bytes)
+            : bytes_(bytes), lastPos_(0), maxPos_(0)
+        {
+        }
+
+        inline void WriteVarint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                bytes_.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            bytes_.push_back((uint8_t)value);
+        }
+
+        inline void WritePos(SubstringPos const & sub)
+        {
+            if (IsNull(sub))
+            {
+                WriteVarint(0);
+                return;
+            }
+            WriteVarint(ZigZag((int64_t)(sub.first - lastPos_)) + 1);
+            WriteVarint(ZigZag((int64_t)(sub.second - sub.first)));
+            lastPos_ = sub.second;
+            maxPos_ = std::max(maxPos_, std::max(sub.first, sub.second));
+        }
+
+        template <typename CHAR_TYPE>
+        inline void WriteChars(CHAR_TYPE const * chars, size_t count, std::true_type /* isByte */)
+        {
+            bytes_.insert(bytes_.end(), (uint8_t const *)chars, (uint8_t const *)(chars + count));
+        }
+
+        template <typename CHAR_TYPE>
+        inline void WriteChars(CHAR_TYPE const * chars, size_t count, std::false_type /* isByte */)
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                WriteVarint((uint64_t)(std::make_unsigned_t<CHAR_TYPE>)chars[index]);
+            }
+        }
+
+        // End of the part of the output buffer the positions written so far refer to
+        inline size_t MaxPos() const
+        {
+            return maxPos_;
+        }
+    };
+
+    // Reading stops at the first error: everything read after is zero
+    class BinaryReader
+    {
+        uint8_t const * bytes_;
+        size_t size_;
+        size_t pos_;
+        size_t lastPos_;
+        size_t maxPos_;
+        bool failed_;
+    public:
+        inline BinaryReader(uint8_t const * bytes, size_t size)
+            : bytes_(bytes), size_(size), pos_(0), lastPos_(0), maxPos_(0), failed_(false)
+        {
+        }
+
+        inline void Fail()
+        {
+            failed_ = true;
+            pos_ = size_;
+        }
+
+        inline uint64_t ReadVarint()
+        {
+            uint64_t value(0);
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if (pos_ >= size_)
+                    break;
+                uint8_t byte(bytes_[pos_++]);
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            Fail();
+            return 0;
+        }
+
+        // The positions are in the buffer that follows, which can't have more characters than there are bytes:
+        // a position before 0, after the end of the bytes or a negative length is an error
+        inline void ReadPos(SubstringPos & sub)
+        {
+            uint64_t delta(ReadVarint());
+            if (delta == 0)
+            {
+                sub = SubstringPos(0, 0);
+                return;
+            }
+            int64_t offset(UnZigZag(delta - 1));
+            int64_t length(UnZigZag(ReadVarint()));
+            if (offset < -(int64_t)lastPos_ || offset > (int64_t)(size_ - lastPos_) ||
+                length < 0 || length > (int64_t)(size_ - lastPos_) - offset)
+            {
+                Fail();
+                sub = SubstringPos(0, 0);
+                return;
+            }
+            sub.first = lastPos_ + (size_t)offset;
+            sub.second = sub.first + (size_t)length;
+            lastPos_ = sub.second;
+            maxPos_ = std::max(maxPos_, sub.second);
+        }
+
+        // Count of elements of a vector: each one takes at least one byte, a greater count is an error
+        inline size_t ReadCount()
+        {
+            uint64_t count(ReadVarint());
+            if (count > size_ - pos_)
+            {
+                Fail();
+                return 0;
+            }
+            return (size_t)count;
+        }
+
+        template <typename CHAR_TYPE, typename ALLOCATOR>
+        inline void ReadChars(std::vector<CHAR_TYPE, ALLOCATOR> & chars, size_t count, std::true_type /* isByte */)
+        {
+            chars.resize(count);
+            std::memcpy(chars.data(), bytes_ + pos_, count);
+            pos_ += count;
+        }
+
+        template <typename CHAR_TYPE, typename ALLOCATOR>
+        inline void ReadChars(std::vector<CHAR_TYPE, ALLOCATOR> & chars, size_t count, std::false_type /* isByte */)
+        {
+            chars.resize(count);
+            for (size_t index = 0; index < count; ++index)
+            {
+                chars[index] = (CHAR_TYPE)ReadVarint();
+            }
+        }
+
+        inline size_t MaxPos() const
+        {
+            return maxPos_;
+        }
+
+        inline size_t Pos() const
+        {
+            return pos_;
+        }
+
+        inline bool Failed() const
+        {
+            return failed_;
+        }
+    };
+
+    inline void WriteData(BinaryWriter & writer, SubstringPos const & sub)
+    {
+        writer.WritePos(sub);
+    }
+
+    inline void WriteData(BinaryWriter &, std::nullptr_t)
+    {
+    }
+
+    template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void WriteData(BinaryWriter & writer, VECTOR const & arr);
+
+    template <typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void WriteData(BinaryWriter & writer, TUPLE_TYPE const & tuple)
+    {
+        ForEachIndex<TUPLE_TYPE>([&](auto index) { WriteData(writer, std::get<decltype(index)::value>(tuple)); });
+    }
+
+    template <typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline void WriteData(BinaryWriter & writer, VECTOR const & arr)
+    {
+        writer.WriteVarint(arr.size());
+        for (auto const & elem : arr)
+        {
+            WriteData(writer, elem);
+        }
+    }
+
+    inline void ReadData(BinaryReader & reader, SubstringPos & sub)
+    {
+        reader.ReadPos(sub);
+    }
+
+    inline void ReadData(BinaryReader &, std::nullptr_t)
+    {
+    }
+
+    template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void ReadData(BinaryReader & reader, VECTOR & arr);
+
+    template <typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void ReadData(BinaryReader & reader, TUPLE_TYPE & tuple)
+    {
+        ForEachIndex<TUPLE_TYPE>([&](auto index) { ReadData(reader, std::get<decltype(index)::value>(tuple)); });
+    }
+
+    // The elements are added as they are read: a count greater than the elements in the bytes doesn't allocate them
+    template <typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline void ReadData(BinaryReader & reader, VECTOR & arr)
+    {
+        arr.clear();
+        for (size_t count(reader.ReadCount()); count > 0 && !reader.Failed(); --count)
+        {
+            arr.emplace_back();
+            ReadData(reader, arr.back());
+        }
+    }
+}
+
+// Appends the binary form of data, with the part of the output buffer of the parser it refers to
+template <typename DATA, typename CHAR_TYPE, typename ALLOCATOR>
+inline void WriteBinary(std::vector<uint8_t> & bytes, DATA const & data, std::vector<CHAR_TYPE, ALLOCATOR> const & buffer)
+{
+    Impl::BinaryWriter writer(bytes);
+    Impl::WriteData(writer, data);
+    size_t count(std::min(writer.MaxPos(), buffer.size()));
+    writer.WriteVarint(count);
+    writer.WriteChars(buffer.data(), count, Bool<sizeof(CHAR_TYPE) == 1>());
+}
+
+// Reads the data written by WriteBinary() and the buffer its positions refer to, as given by the parser.
+// Returns the count of bytes read, so that several of them can follow each other, or 0 if the bytes aren't valid.
+template <typename DATA, typename CHAR_TYPE, typename ALLOCATOR>
+inline size_t ReadBinary(uint8_t const * bytes, size_t size, DATA * data, std::vector<CHAR_TYPE, ALLOCATOR> * buffer)
+{
+    Impl::BinaryReader reader(bytes, size);
+    Impl::ReadData(reader, *data);
+    size_t count(reader.ReadCount());
+    if (count < reader.MaxPos())
+        reader.Fail();
+    if (reader.Failed())
+        return 0;
+    reader.ReadChars(*buffer, count, Bool<sizeof(CHAR_TYPE) == 1>());
+    return reader.Failed() ? 0 : reader.Pos();
+}
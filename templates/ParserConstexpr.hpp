@@ -0,0 +1,284 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// recognition of literals by the rules at compile time
+#pragma once
+
+#include "ParserGrammar.hpp"
+#include <cstdio>
+
+// Needs the C++14 constexpr functions (loops and variables)
+#if (defined(__cpp_constexpr) && __cpp_constexpr >= 201304) || (defined(_MSC_VER) && _MSC_VER >= 1910)
+#define PARSER_CONSTEXPR_MATCH
+#endif
+
+#ifdef PARSER_CONSTEXPR_MATCH
+
+namespace Impl
+{
+    // Carries a primitive type without building it, primitives aren't literal types
+    template <typename TYPE>
+    class TypeTag
+    {
+    };
+
+    // Input of the compile time matching: characters are read as the string input of the parser does
+    class ConstInput
+    {
+        char const * data_;
+        size_t size_;
+    public:
+        template <size_t SIZE>
+        constexpr ConstInput(char const (&data)[SIZE])
+            : data_(data), size_(SIZE - 1)
+        {
+        }
+
+        constexpr ConstInput(char const * data, size_t size)
+            : data_(data), size_(size)
+        {
+        }
+
+        constexpr ConstInput(std::string_view data)
+            : data_(data.data()), size_(data.size())
+        {
+        }
+
+        constexpr size_t Size() const { return size_; }
+        constexpr int operator[](size_t pos) const { return pos < size_ ? (int)data_[pos] : EOF; }
+    };
+
+    enum : size_t { ConstNoMatch = SIZE_MAX };
+
+    // End of the match, and whether a Cut() has been passed that the enclosing choice point has to take
+    class ConstMatchResult
+    {
+    public:
+        size_t End;
+        bool Cut;
+    };
+
+    template <size_t INDEX>
+    constexpr ConstMatchResult ConstMatch(ConstInput /* input */, size_t pos, TypeTag<Idx<INDEX> >)
+    {
+        return { pos, false };
+    }
+
+    constexpr bool ConstMatchChar(int /* inputChar */)
+    {
+        return false;
+    }
+
+    template <typename... CODES>
+    constexpr bool ConstMatchChar(int inputChar, MaxCharType code, CODES... otherCodes)
+    {
+        return inputChar == code || ConstMatchChar(inputChar, otherCodes...);
+    }
+
+    template <MaxCharType... CODES>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<CharVal<CODES...> >)
+    {
+        return { (input[pos] != EOF && ConstMatchChar(input[pos], CODES...)) ? pos + 1 : ConstNoMatch, false };
+    }
+
+    template <MaxCharType CH1, MaxCharType CH2>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<CharRange<CH1, CH2> >)
+    {
+        return { (input[pos] != EOF && input[pos] >= CH1 && input[pos] <= CH2) ? pos + 1 : ConstNoMatch, false };
+    }
+
+    template <MaxCharType... CODES>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<Literal<CODES...> >)
+    {
+        MaxCharType const codes[] = { CODES... };
+        for (size_t index = 0; index < sizeof...(CODES); ++index)
+        {
+            if (input[pos + index] == EOF || input[pos + index] != codes[index])
+                return { ConstNoMatch, false };
+        }
+        return { pos + sizeof...(CODES), false };
+    }
+
+    template <MaxCharType... CODES>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<ILiteral<CODES...> >)
+    {
+        MaxCharType const codes[] = { CODES... };
+        for (size_t index = 0; index < sizeof...(CODES); ++index)
+        {
+            MaxCharType mask(CaseFoldMask(codes[index]));
+            if (input[pos + index] == EOF || (input[pos + index] | mask) != (codes[index] | mask))
+                return { ConstNoMatch, false };
+        }
+        return { pos + sizeof...(CODES), false };
+    }
+
+    constexpr ConstMatchResult ConstMatchItems(ConstInput /* input */, size_t pos, bool cut)
+    {
+        return { pos, cut };
+    }
+
+    // Sequence: a Cut() is passed to the enclosing choice point, even on failure
+    template <typename PRIMITIVE, typename... OTHER_PRIMITIVES>
+    constexpr ConstMatchResult ConstMatchItems(ConstInput input, size_t pos, bool cut, TypeTag<PRIMITIVE> primitive, TypeTag<OTHER_PRIMITIVES>... otherPrimitives)
+    {
+        ConstMatchResult result(ConstMatch(input, pos, primitive));
+        if (result.End == ConstNoMatch)
+            return { ConstNoMatch, cut || result.Cut };
+        return ConstMatchItems(input, result.End, cut || result.Cut, otherPrimitives...);
+    }
+
+    constexpr ConstMatchResult ConstMatchAlternatives(ConstInput /* input */, size_t /* pos */, size_t bestEnd)
+    {
+        return { bestEnd, false };
+    }
+
+    // Same choice as the parser: the longest match, the first one on equal length, empty matches only count for the
+    // last alternative. An alternative that passed a Cut() is the last one tried: it fails the choice if it doesn't match,
+    // but Success() still keeps a longer match of the alternatives tried before it
+    template <typename PRIMITIVE, typename... OTHER_PRIMITIVES>
+    constexpr ConstMatchResult ConstMatchAlternatives(ConstInput input, size_t pos, size_t bestEnd, TypeTag<PRIMITIVE> primitive, TypeTag<OTHER_PRIMITIVES>... otherPrimitives)
+    {
+        ConstMatchResult result(ConstMatch(input, pos, primitive));
+        if (result.Cut)
+            return { (result.End != ConstNoMatch && bestEnd != ConstNoMatch && bestEnd > result.End) ? bestEnd : result.End, false };
+        if (sizeof...(OTHER_PRIMITIVES) == 0)
+        {
+            if (result.End == ConstNoMatch)
+                return { bestEnd, false };
+            return { (bestEnd != ConstNoMatch && bestEnd > result.End) ? bestEnd : result.End, false };
+        }
+        if (result.End != ConstNoMatch && result.End > pos && (bestEnd == ConstNoMatch || result.End > bestEnd))
+            bestEnd = result.End;
+        return ConstMatchAlternatives(input, pos, bestEnd, otherPrimitives...);
+    }
+
+    // Idx<>() tags in a choice aren't alternatives
+    template <size_t INDEX, typename... OTHER_PRIMITIVES>
+    constexpr ConstMatchResult ConstMatchAlternatives(ConstInput input, size_t pos, size_t bestEnd, TypeTag<Idx<INDEX> >, TypeTag<OTHER_PRIMITIVES>... otherPrimitives)
+    {
+        return ConstMatchAlternatives(input, pos, bestEnd, otherPrimitives...);
+    }
+
+    constexpr ConstMatchResult ConstMatchFirst(ConstInput /* input */, size_t /* pos */)
+    {
+        return { ConstNoMatch, false };
+    }
+
+    template <typename PRIMITIVE, typename... OTHER_PRIMITIVES>
+    constexpr ConstMatchResult ConstMatchFirst(ConstInput input, size_t pos, TypeTag<PRIMITIVE> primitive, TypeTag<OTHER_PRIMITIVES>... otherPrimitives)
+    {
+        ConstMatchResult result(ConstMatch(input, pos, primitive));
+        if (result.Cut || result.End != ConstNoMatch)
+            return { result.End, false };
+        return ConstMatchFirst(input, pos, otherPrimitives...);
+    }
+
+    template <typename... PRIMITIVES>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<SequenceType<SeqTypeSeq, PRIMITIVES...> >)
+    {
+        return ConstMatchItems(input, pos, false, TypeTag<PRIMITIVES>()...);
+    }
+
+    template <typename SEQ_TYPE, typename... PRIMITIVES>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<SequenceType<SEQ_TYPE, PRIMITIVES...> >)
+    {
+        return ConstMatchAlternatives(input, pos, ConstNoMatch, TypeTag<PRIMITIVES>()...);
+    }
+
+    template <typename SEQ_TYPE, typename... PRIMITIVES, size_t... ORDER>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<PreferType<false, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...> >)
+    {
+        return ConstMatchAlternatives(input, pos, ConstNoMatch, TypeTag<typename std::tuple_element<ORDER, std::tuple<PRIMITIVES...> >::type>()...);
+    }
+
+    template <typename SEQ_TYPE, typename... PRIMITIVES, size_t... ORDER>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<PreferType<true, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...> >)
+    {
+        return ConstMatchFirst(input, pos, TypeTag<typename std::tuple_element<ORDER, std::tuple<PRIMITIVES...> >::type>()...);
+    }
+
+    template <size_t MIN_COUNT, size_t MAX_COUNT, typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<RepeatType<MIN_COUNT, MAX_COUNT, PRIMITIVE> >)
+    {
+        size_t count(0);
+        for (; count < MAX_COUNT; ++count)
+        {
+            ConstMatchResult result(ConstMatch(input, pos, TypeTag<PRIMITIVE>()));
+            if (result.End == ConstNoMatch)
+            {
+                if (result.Cut)
+                    return { ConstNoMatch, false };
+                break;
+            }
+            if (result.End == pos)
+            {
+                // an empty element would match up to MAX_COUNT times
+                count = MAX_COUNT;
+                break;
+            }
+            pos = result.End;
+        }
+        return { count >= MIN_COUNT ? pos : ConstNoMatch, false };
+    }
+
+    template <typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<RepeatType<0, 1, PRIMITIVE> >)
+    {
+        ConstMatchResult result(ConstMatch(input, pos, TypeTag<PRIMITIVE>()));
+        if (result.End != ConstNoMatch)
+            return { result.End, false };
+        return { result.Cut ? ConstNoMatch : pos, false };
+    }
+
+    template <bool EXPECTED, typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<PredicateType<EXPECTED, PRIMITIVE> >)
+    {
+        return { (ConstMatch(input, pos, TypeTag<PRIMITIVE>()).End != ConstNoMatch) == EXPECTED ? pos : ConstNoMatch, false };
+    }
+
+    constexpr ConstMatchResult ConstMatch(ConstInput /* input */, size_t pos, TypeTag<CutType>)
+    {
+        return { pos, true };
+    }
+
+    template <typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<SkipType<PRIMITIVE> >)
+    {
+        return ConstMatch(input, pos, TypeTag<PRIMITIVE>());
+    }
+
+    template <typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<NoCaptureType<PRIMITIVE> >)
+    {
+        return ConstMatch(input, pos, TypeTag<PRIMITIVE>());
+    }
+}
+
+// End of the match of the rule from pos, as the parser would do it, Impl::ConstNoMatch if the rule doesn't match.
+// Usable in constant expressions, i.e. to split a literal address: MatchEnd<RFC5322::LocalPart>("info@example.com") == 4
+template <typename RULE>
+constexpr size_t MatchEnd(Impl::ConstInput input, size_t pos = 0)
+{
+    return ConstMatch(input, pos, Impl::TypeTag<RULE>()).End;
+}
+
+// True if the whole input matches the rule, as ParseExact() would: static_assert(Valid<RFC5322::AddrSpec>("info@example.com"), "")
+template <typename RULE>
+constexpr bool Valid(Impl::ConstInput input)
+{
+    return MatchEnd<RULE>(input) == input.Size();
+}
+
+// A template on the input (always Impl::ConstInput): only the rules used in constant expressions get compiled
+#define PARSER_RULE_CONSTEXPR(name, ...) \
+    template <typename CONST_INPUT> \
+    constexpr Impl::ConstMatchResult ConstMatch(CONST_INPUT input, size_t pos, Impl::TypeTag<name>) \
+    { return ConstMatch(input, pos, Impl::TypeTag<decltype(__VA_ARGS__)>()); }
+
+#else
+
+#define PARSER_RULE_CONSTEXPR(name, ...)
+
+#endif
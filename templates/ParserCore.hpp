@@ -6,7 +6,7 @@
 // some rules from the ABNF RFC core
 #pragma once
 
-#include "ParserGrammar.hpp"
+#include "ParserRegular.hpp"
 
 // Core rules as defined in the Appendix B https://tools.ietf.org/html/rfc5234#appendix-B
 
@@ -47,5 +47,5 @@ namespace RFC5234Core
     // WSP            =  SP / HTAB
     PARSER_RULE(WSP, Alternatives(SP(), HTAB()));
     // LWSP           =  *(WSP / CRLF WSP)
-    PARSER_RULE(LWSP, Repeat(Alternatives(WSP(), Sequence(CRLF(), WSP()))));
+    PARSER_RULE(LWSP, Regular(Repeat(Alternatives(WSP(), Sequence(CRLF(), WSP())))));
 }
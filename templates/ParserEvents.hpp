@@ -0,0 +1,137 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// event driven parsing: visitor callbacks for the rules and for each element of a list, instead of building the whole data
+#pragma once
+
+#include "ParserGrammar.hpp"
+
+// Destination of a list rule defined with HeadTail(), e.g. RFC5322::AddressList: each element is given to
+// visitor.OnListElement(elem) as soon as it is parsed, instead of being stored in the list data.
+// The same element data is used for all the elements, its positions are in the output buffer of the parser until
+// OnListElement() returns: the output is then rewound, so that only one element at a time is in memory.
+// The elements are given before the list is known to be valid, ParseExact() tells it at the end.
+// The input of the elements given is released when no enclosing choice point can come back to it, see
+// ParserIO::Commit(): a streamed list is then parsed in constant memory, but a failure leaves the parser after the
+// last element given instead of at the start of the list.
+template <typename ELEM_DATA, typename VISITOR>
+class ListEvents
+{
+    VISITOR & visitor_;
+    ELEM_DATA elem_;
+    size_t count_;
+public:
+    inline ListEvents(VISITOR & visitor)
+        : visitor_(visitor), elem_(), count_(0)
+    {
+    }
+
+    inline ELEM_DATA * NewElem(std::pmr::memory_resource * resource)
+    {
+        // the vectors of the previous element keep their capacity
+        Impl::ResetData(elem_);
+        Impl::UseResource(elem_, resource);
+        return &elem_;
+    }
+
+    inline void EndElem()
+    {
+        if (false == IsEmpty(elem_))
+        {
+            ELEM_DATA const & elem(elem_);
+            count_++;
+            visitor_.OnListElement(elem);
+        }
+    }
+
+    // Count of elements given to the visitor
+    inline size_t Count() const
+    {
+        return count_;
+    }
+};
+
+template <typename ELEM_DATA, typename VISITOR>
+inline ListEvents<ELEM_DATA, VISITOR> Make_ListEvents(VISITOR & visitor)
+{
+    return ListEvents<ELEM_DATA, VISITOR>(visitor);
+}
+
+// HeadTail() parsed element by element into the list events
+template <typename PARSER, typename ELEM_DATA, typename VISITOR, typename HEAD, size_t MAX_COUNT, typename TAIL>
+inline bool Parse(PARSER & parser, ListEvents<ELEM_DATA, VISITOR> * events, char const * ruleName,
+    SequenceType<SeqTypeSeq, Idx<INDEX_THIS>, RepeatType<1, 1, HEAD>, Idx<INDEX_THIS>, RepeatType<0, MAX_COUNT, TAIL> > const & what)
+{
+    std::nullptr_t noResult(nullptr);
+    auto ioState(parser.template Save<false, false>(noResult, ruleName));
+    size_t outputPos(parser.Output().Pos());
+
+    auto const & head(std::get<1>(what.Primitives()).Elem());
+    if (false == Parse(parser, events->NewElem(parser.Resource()), head.Name(), head))
+        return false;
+    events->EndElem();
+    parser.Output().SetPos(outputPos);
+    parser.Commit();
+
+    // as Repeat()
+    auto tailState(parser.template Save<true, false>(noResult, ruleName));
+    typename PARSER::ChoicePoint choicePoint(parser);
+    auto const & tail(std::get<3>(what.Primitives()).Elem());
+    for (size_t count = 0; count < MAX_COUNT; ++count)
+    {
+        bool parsed = Parse(parser, events->NewElem(parser.Resource()), tail.Name(), tail);
+        if (choicePoint.TakeCut() && !parsed)
+            return false;
+        if (!parsed)
+            break;
+        events->EndElem();
+        parser.Output().SetPos(outputPos);
+        choicePoint.Advance();
+        parser.Commit();
+    }
+    parser.LastRepeatErrors().clear();
+    std::swap(parser.LastRepeatErrors(), parser.Errors());
+    tailState.Success();
+    return ioState.Success();
+}
+
+// Parser calling visitor.OnBegin(ruleName) before each rule is parsed, then visitor.OnEnd(ruleName, inputSpan) if the
+// rule matched, or visitor.OnFail(ruleName). The events nest as the rules, but the rules parsed by the alternatives
+// that are not kept, or before a backtracking, are reported too: only the outermost events are final.
+template <typename PARSER_IO, typename VISITOR>
+class EventParserIO : public PARSER_IO
+{
+    VISITOR & visitor_;
+public:
+    inline EventParserIO(PARSER_IO parser, VISITOR & visitor)
+        : PARSER_IO(std::move(parser)), visitor_(visitor)
+    {
+    }
+
+    inline VISITOR & Visitor()
+    {
+        return visitor_;
+    }
+};
+
+template <typename PARSER_IO, typename VISITOR>
+inline EventParserIO<PARSER_IO, VISITOR> Make_EventParser(PARSER_IO parser, VISITOR & visitor)
+{
+    return EventParserIO<PARSER_IO, VISITOR>(std::move(parser), visitor);
+}
+
+template <typename PARSER_IO, typename VISITOR, typename TYPE, typename PRIMITIVE>
+inline bool ParseRule(EventParserIO<PARSER_IO, VISITOR> & parser, TYPE result, char const * ruleName, PRIMITIVE const & definition)
+{
+    size_t inputPos(parser.Input().Pos());
+    parser.Visitor().OnBegin(ruleName);
+    if (Parse(parser, result, ruleName, definition))
+    {
+        parser.Visitor().OnEnd(ruleName, SubstringPos(inputPos, parser.Input().Pos()));
+        return true;
+    }
+    parser.Visitor().OnFail(ruleName);
+    return false;
+}
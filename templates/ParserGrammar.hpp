@@ -7,8 +7,10 @@
 #pragma once
 
 #include "ParserBase.hpp"
+#include "ParserProfile.hpp"
 #include <tuple>
 #include <cctype>
+#include <iomanip>
 
 template <MaxCharType... CODES>
 class CharVal
@@ -24,6 +26,22 @@ public:
     static char const * Name() { return "CharRange"; }
 };
 
+// Literal matches a whole string of characters at once, instead of a Sequence of CharVal
+template <MaxCharType... CODES>
+class Literal
+{
+public:
+    static char const * Name() { return "Literal"; }
+};
+
+// ILiteral matches a whole string of ASCII characters at once, ignoring case as RFC 5234 quoted strings do
+template <MaxCharType... CODES>
+class ILiteral
+{
+public:
+    static char const * Name() { return "ILiteral"; }
+};
+
 template <MaxCharType CH>
 inline bool Match(int inputChar, CharVal<CH>)
 {
@@ -42,6 +60,37 @@ inline bool Match(int inputChar, CharRange<CH1, CH2>)
     return inputChar >= CH1 && inputChar <= CH2;
 }
 
+template <typename INPUT_CHAR, MaxCharType... CODES>
+inline bool Match(INPUT_CHAR const * inputChars, Literal<CODES...>)
+{
+    static MaxCharType const codes[] = { CODES... };
+    // lowers to a single memcmp when the input window has the same type as the codes
+    return std::equal(codes, codes + sizeof...(CODES), inputChars);
+}
+
+namespace Impl
+{
+    inline constexpr MaxCharType CaseFoldMask(MaxCharType ch)
+    {
+        return ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z')) ? 0x20 : 0;
+    }
+}
+
+template <typename INPUT_CHAR, MaxCharType... CODES>
+inline bool Match(INPUT_CHAR const * inputChars, ILiteral<CODES...>)
+{
+    // letters are folded to lower case by setting bit 0x20, other characters are compared as is
+    static MaxCharType const masks[] = { Impl::CaseFoldMask(CODES)... };
+    static MaxCharType const folded[] = { (CODES | Impl::CaseFoldMask(CODES))... };
+    // no early exit so that the loop gets vectorized
+    MaxCharType diff = 0;
+    for (size_t i = 0; i < sizeof...(CODES); ++i)
+    {
+        diff |= ((MaxCharType)inputChars[i] | masks[i]) ^ folded[i];
+    }
+    return diff == 0;
+}
+
 #define INDEX_NONE std::numeric_limits<size_t>::max()          // Used to define a primitive that has no specific member
 #define INDEX_THIS (std::numeric_limits<size_t>::max()-1)      // Use to define a primitive that parse current object instead of a member
 
@@ -141,6 +190,130 @@ inline RepeatType<0, 1, SequenceType<SeqTypeSeq, PRIMITIVE, OTHER_PRIMITIVES...>
     return Optional(Sequence(primitive, otherPrimitives...));
 }
 
+// Syntactic predicates: test the primitive at the current position without consuming input nor writing output
+template <bool EXPECTED, typename PRIMITIVE>
+class PredicateType
+{
+    PRIMITIVE primitive_;
+public:
+    inline PredicateType(PRIMITIVE primitive)
+        : primitive_(primitive)
+    {
+    }
+
+    static char const * Name() { return EXPECTED ? "And" : "Not"; }
+
+    inline constexpr PRIMITIVE const & Elem() const { return primitive_; }
+    inline PRIMITIVE & Elem() { return primitive_; }
+};
+
+// And succeeds if the primitive matches
+template <typename PRIMITIVE>
+inline PredicateType<true, PRIMITIVE> And(PRIMITIVE primitive)
+{
+    return PredicateType<true, PRIMITIVE>(primitive);
+}
+
+// Not succeeds if the primitive doesn't match
+template <typename PRIMITIVE>
+inline PredicateType<false, PRIMITIVE> Not(PRIMITIVE primitive)
+{
+    return PredicateType<false, PRIMITIVE>(primitive);
+}
+
+class CutType
+{
+public:
+    static char const * Name() { return "Cut"; }
+};
+
+// Cut inside a Sequence: if the rest of the sequence fails, the innermost enclosing Alternatives, Union, Repeat or Optional
+// fails at once without trying another way
+inline CutType Cut()
+{
+    return CutType();
+}
+
+// Matches the primitive without writing output nor building results, e.g. comments nobody reads.
+// It takes no place in the data.
+template <typename PRIMITIVE>
+class SkipType
+{
+    PRIMITIVE primitive_;
+public:
+    inline SkipType(PRIMITIVE primitive)
+        : primitive_(primitive)
+    {
+    }
+
+    static char const * Name() { return "Skip"; }
+
+    inline constexpr PRIMITIVE const & Elem() const { return primitive_; }
+    inline PRIMITIVE & Elem() { return primitive_; }
+};
+
+template <typename PRIMITIVE>
+inline SkipType<PRIMITIVE> Skip(PRIMITIVE primitive)
+{
+    return SkipType<PRIMITIVE>(primitive);
+}
+
+// Matches the primitive writing its output, its result is only the SubstringPos of the output: no nested data is built.
+template <typename PRIMITIVE>
+class NoCaptureType
+{
+    PRIMITIVE primitive_;
+public:
+    inline NoCaptureType(PRIMITIVE primitive)
+        : primitive_(primitive)
+    {
+    }
+
+    static char const * Name() { return "NoCapture"; }
+
+    inline constexpr PRIMITIVE const & Elem() const { return primitive_; }
+    inline PRIMITIVE & Elem() { return primitive_; }
+};
+
+template <typename PRIMITIVE>
+inline NoCaptureType<PRIMITIVE> NoCapture(PRIMITIVE primitive)
+{
+    return NoCaptureType<PRIMITIVE>(primitive);
+}
+
+// Prefer tries the alternatives of an Alternatives or Union in the given order, e.g. from the most to the least frequent
+// winner of a profile (see ParserProfile.hpp). The data layout and the result are unchanged: the longest match still wins,
+// the remaining alternatives are only skipped once one of them reached the end of the input.
+template <bool FIRST_MATCH, typename CHOICE, size_t... ORDER>
+class PreferType
+{
+    CHOICE choice_;
+public:
+    inline PreferType(CHOICE choice)
+        : choice_(choice)
+    {
+    }
+
+    static char const * Name() { return CHOICE::Name(); }
+
+    inline constexpr CHOICE const & Elem() const { return choice_; }
+    inline CHOICE & Elem() { return choice_; }
+};
+
+template <size_t... ORDER, typename SEQ_TYPE, typename... PRIMITIVES>
+inline PreferType<false, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...> Prefer(SequenceType<SEQ_TYPE, PRIMITIVES...> choice)
+{
+    return PreferType<false, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...>(choice);
+}
+
+// PreferFirst keeps the first alternative that matches in the given order, without trying the others.
+// Only for choices whose alternatives can't both match at the same position, else the result may change.
+template <size_t... ORDER, typename SEQ_TYPE, typename... PRIMITIVES>
+inline PreferType<true, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...> PreferFirst(SequenceType<SEQ_TYPE, PRIMITIVES...> choice)
+{
+    return PreferType<true, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...>(choice);
+}
+
 // Use head and tail when primitiveHead is the first elements of a list and primitiveTails contains the others elements of the list
 template <typename PRIMITIVE, typename... OTHER_PRIMITIVES>
 inline auto HeadTail(PRIMITIVE primitiveHead, OTHER_PRIMITIVES... primitiveTail)
@@ -181,6 +354,14 @@ inline auto HeadTail(PRIMITIVE primitiveHead, OTHER_PRIMITIVES... primitiveTail)
 
 namespace Impl
 {
+    // Number of true flags among the count first ones.
+    // The flags come from a pack expansion, so that a sequence is handled by one instantiation instead of one per element.
+    template <size_t SIZE>
+    inline constexpr size_t CountFlags(bool const (&flags)[SIZE], size_t count = SIZE, size_t position = 0)
+    {
+        return (position < count && position < SIZE) ? (flags[position] ? 1 : 0) + CountFlags(flags, count, position + 1) : 0;
+    }
+
     template <typename TYPE>
     class Constantness : public std::false_type
     {
@@ -203,7 +384,28 @@ namespace Impl
 
     template <typename PRIMITIVE1, typename PRIMITIVE2, typename... OTHER_PRIMITIVES>
     class Constantness<SequenceType<SeqTypeSeq, PRIMITIVE1, PRIMITIVE2, OTHER_PRIMITIVES...> >
-        : public Bool<Constantness<PRIMITIVE1>::value && Constantness<SequenceType<SeqTypeSeq, PRIMITIVE2, OTHER_PRIMITIVES...> >::value>
+        : public Bool<CountFlags<2 + sizeof...(OTHER_PRIMITIVES)>({ Constantness<PRIMITIVE1>::value, Constantness<PRIMITIVE2>::value,
+            Constantness<OTHER_PRIMITIVES>::value... }) == 2 + sizeof...(OTHER_PRIMITIVES)>
+    {
+    };
+
+    template <MaxCharType... CODES>
+    class Constantness<Literal<CODES...> > : public std::true_type
+    {
+    };
+
+    template <bool EXPECTED, typename PRIMITIVE>
+    class Constantness<PredicateType<EXPECTED, PRIMITIVE> > : public std::true_type
+    {
+    };
+
+    template <>
+    class Constantness<CutType> : public std::true_type
+    {
+    };
+
+    template <typename PRIMITIVE>
+    class Constantness<SkipType<PRIMITIVE> > : public std::true_type
     {
     };
 
@@ -213,21 +415,26 @@ namespace Impl
     {
     };
 
+    template <bool FIRST_MATCH, typename CHOICE, size_t... ORDER>
+    class Constantness<PreferType<FIRST_MATCH, CHOICE, ORDER...> > : public Constantness<CHOICE>
+    {
+    };
+
     template <typename PRIMITIVE>
     class VariablesCount : public Idx<Constantness<PRIMITIVE>::value ? 0 : 1>
     {
 
     };
 
-    template <typename SEQ_TYPE, typename PRIMITIVE>
-    class VariablesCount<SequenceType<SEQ_TYPE, PRIMITIVE> > : public Idx<Constantness<PRIMITIVE>::value ? 0 : 1>
+    template <bool FIRST_MATCH, typename CHOICE, size_t... ORDER>
+    class VariablesCount<PreferType<FIRST_MATCH, CHOICE, ORDER...> > : public VariablesCount<CHOICE>
     {
 
     };
 
-    template <typename SEQ_TYPE, typename PRIMITIVE1, typename PRIMITIVE2, typename... OTHER_PRIMITIVES>
-    class VariablesCount<SequenceType<SEQ_TYPE, PRIMITIVE1, PRIMITIVE2, OTHER_PRIMITIVES...> >
-    : public Idx<VariablesCount<SequenceType<SEQ_TYPE, PRIMITIVE1> >::value + VariablesCount<SequenceType<SEQ_TYPE, PRIMITIVE2, OTHER_PRIMITIVES...> >::value>
+    template <typename SEQ_TYPE, typename... PRIMITIVES>
+    class VariablesCount<SequenceType<SEQ_TYPE, PRIMITIVES...> >
+        : public Idx<sizeof...(PRIMITIVES) - CountFlags<sizeof...(PRIMITIVES)>({ Constantness<PRIMITIVES>::value... })>
     {
 
     };
@@ -534,10 +741,106 @@ inline bool Parse(PARSER & parser, std::nullptr_t, char const * ruleName, CharRa
     return false;
 }
 
+template <typename PARSER, MaxCharType... CODES>
+inline bool Parse(PARSER & parser, std::nullptr_t, char const * /* ruleName */, Literal<CODES...> const & what, bool escape = false)
+{
+    // Peek() may give nullptr when the input is too short, see ParserValidate.hpp
+    auto const * inputChars(parser.Input().Peek(sizeof...(CODES)));
+    if (inputChars != nullptr && Match(inputChars, what))
+    {
+        parser.Output().Write(inputChars, sizeof...(CODES), escape);
+        parser.Input().Skip(sizeof...(CODES));
+        return true;
+    }
+    parser.Errors().push_back([inputPos = parser.Input().Pos()](std::ostream & cerr, std::string const & indent)
+    {
+        char const literal[] = { (char)CODES..., 0 };
+        cerr << indent << "#" << inputPos << ": Expected literal \"" << literal << "\"" << std::endl;
+    });
+    return false;
+}
+
+template <typename PARSER, MaxCharType... CODES>
+inline bool Parse(PARSER & parser, std::nullptr_t, char const * ruleName, ILiteral<CODES...> const & what, bool escape = false)
+{
+    // Peek() may give nullptr when the input is too short, see ParserValidate.hpp
+    auto const * inputChars(parser.Input().Peek(sizeof...(CODES)));
+    if (inputChars != nullptr && Match(inputChars, what))
+    {
+        parser.Output().Write(inputChars, sizeof...(CODES), escape);
+        parser.Input().Skip(sizeof...(CODES));
+        return true;
+    }
+    parser.Errors().push_back([inputPos = parser.Input().Pos()](std::ostream & cerr, std::string const & indent)
+    {
+        char const literal[] = { (char)CODES..., 0 };
+        cerr << indent << "#" << inputPos << ": Expected case-insensitive literal \"" << literal << "\"" << std::endl;
+    });
+    return false;
+}
+
+// Destination of a single member of DATA, reached through the members at PATH, e.g. the domain of an addr-spec:
+// Projection<AddrSpecData, NAMEDTUPLE_INDEX(AddrSpecData, DomainPart), NAMEDTUPLE_INDEX(TextWithCommData, Content)>.
+// The other members are only matched, with the output suspended: no data to build, to write nor to roll back.
+template <typename DATA, size_t... PATH>
+class Projection;
+
+template <typename DATA>
+class Projection<DATA>
+{
+public:
+    using Type = DATA;
+    DATA Value = {};
+
+    inline DATA & Get() { return Value; }
+    inline DATA const & Get() const { return Value; }
+};
+
+template <typename DATA, size_t INDEX, size_t... PATH>
+class Projection<DATA, INDEX, PATH...>
+{
+public:
+    using Member = Projection<std::remove_reference_t<decltype(std::get<INDEX>(std::declval<DATA &>()))>, PATH...>;
+    using Type = typename Member::Type;
+    Member Field = {};
+
+    inline Type & Get() { return Field.Get(); }
+    inline Type const & Get() const { return Field.Get(); }
+};
+
 namespace Impl
 {
+    // Member not in the path of a projection
+    class SkippedField
+    {
+    };
+
+    template <typename DATA>
+    inline DATA * ProjectionDest(Projection<DATA> & member)
+    {
+        return &member.Value;
+    }
+
+    template <typename DATA, size_t INDEX, size_t... PATH>
+    inline Projection<DATA, INDEX, PATH...> * ProjectionDest(Projection<DATA, INDEX, PATH...> & member)
+    {
+        return &member;
+    }
+
+    template <size_t INDEX, typename DATA, size_t... PATH>
+    inline auto FieldNotNull(Idx<INDEX>, Projection<DATA, INDEX, PATH...> * projection) -> decltype(ProjectionDest(projection->Field))
+    {
+        return ProjectionDest(projection->Field);
+    }
+
+    template <size_t INDEX, typename DATA, size_t MEMBER_INDEX, size_t... PATH, ENABLED_IF(INDEX != MEMBER_INDEX && INDEX != INDEX_THIS && INDEX != INDEX_NONE)>
+    inline SkippedField FieldNotNull(Idx<INDEX>, Projection<DATA, MEMBER_INDEX, PATH...> *)
+    {
+        return SkippedField();
+    }
+
     template <size_t INDEX, typename TUPLE_TYPE, ENABLED_IF(INDEX != INDEX_THIS && INDEX != INDEX_NONE), ENABLED_IF_TUPLISH(TUPLE_TYPE)>
-    inline auto FieldNotNull(Idx<INDEX> idx, TUPLE_TYPE * type) -> decltype(&std::get<INDEX>(*type))
+    inline auto FieldNotNull(Idx<INDEX>, TUPLE_TYPE * type) -> decltype(&std::get<INDEX>(*type))
     {
         if (type != nullptr)
         {
@@ -547,47 +850,47 @@ namespace Impl
     }
 
     template <size_t INDEX, typename TYPE, ENABLED_IF(INDEX != INDEX_THIS && INDEX != INDEX_NONE), ENABLED_IF_NOT_TUPLISH(TYPE)>
-    inline std::nullptr_t FieldNotNull(Idx<INDEX> idx, TYPE * type)
+    inline std::nullptr_t FieldNotNull(Idx<INDEX>, TYPE *)
     {
         return nullptr;
     }
 
     template <size_t INDEX, typename TYPE, ENABLED_IF(INDEX == INDEX_THIS)>
-    inline TYPE * FieldNotNull(Idx<INDEX> idx, TYPE * type)
+    inline TYPE * FieldNotNull(Idx<INDEX>, TYPE * type)
     {
         return type;
     }
 
     template <size_t INDEX, typename TYPE_PTR, ENABLED_IF(INDEX == INDEX_NONE)>
-    inline std::nullptr_t FieldNotNull(Idx<INDEX> idx, TYPE_PTR type)
+    inline std::nullptr_t FieldNotNull(Idx<INDEX>, TYPE_PTR)
     {
         return nullptr;
     }
 
     template <size_t INDEX>
-    inline std::nullptr_t FieldNotNull(Idx<INDEX> idx, std::nullptr_t)
+    inline std::nullptr_t FieldNotNull(Idx<INDEX>, std::nullptr_t)
     {
         return nullptr;
     }
 
-    template <typename ELEM>
-    inline void PushBackIfNotNull(std::vector<ELEM> * elems, ELEM const & elem)
+    template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void PushBackIfNotNull(VECTOR * elems, typename VECTOR::value_type && elem)
     {
         if (elems != nullptr)
         {
-            elems->push_back(elem);
+            elems->push_back(std::move(elem));
         }
     }
 
-    template <typename TYPE, typename ELEM>
-    inline void PushBackIfNotNull(TYPE &&, ELEM const &)
+    template <typename TYPE>
+    inline void PushBackIfNotNull(TYPE &&, std::nullptr_t)
     {
     }
 
-    template <typename ELEM>
-    inline ELEM ElemTypeOrNull(std::vector<ELEM> const *);
+    template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline typename VECTOR::value_type ElemTypeOrNull(VECTOR const *);
 
-    template <typename TYPE>
+    template <typename TYPE, ENABLED_IF_NOT_VECTOR(TYPE)>
     inline std::nullptr_t ElemTypeOrNull(TYPE const *);
     inline std::nullptr_t ElemTypeOrNull(std::nullptr_t);
 
@@ -602,6 +905,41 @@ namespace Impl
         return nullptr;
     }
 
+    // Nothing is written to the output of the parser while in scope, see Skip()
+    template <typename PARSER>
+    class SuspendedOutput
+    {
+        PARSER & parser_;
+    public:
+        inline explicit SuspendedOutput(PARSER & parser)
+            : parser_(parser)
+        {
+            parser_.Output().Suspend();
+        }
+
+        inline ~SuspendedOutput()
+        {
+            parser_.Output().Resume();
+        }
+
+        SuspendedOutput(SuspendedOutput const &) = delete;
+        SuspendedOutput & operator=(SuspendedOutput const &) = delete;
+    };
+
+    template <typename PARSER, typename DEST_PTR, typename PRIMITIVE>
+    inline bool ParseField(PARSER & parser, DEST_PTR dest, char const * name, PRIMITIVE const & item)
+    {
+        return Parse(parser, dest, name, item);
+    }
+
+    // as Skip()
+    template <typename PARSER, typename PRIMITIVE>
+    inline bool ParseField(PARSER & parser, SkippedField, char const * name, PRIMITIVE const & item)
+    {
+        SuspendedOutput<PARSER> suspended(parser);
+        return Parse(parser, nullptr, name, item);
+    }
+
     template <size_t IMPLICIT_INDEX, typename NEXT_ELEMENT, typename SEQ_TYPE, typename... PRIMITIVES>
     class ResolveIndex : public Idx<
         (CONSTANT(IsConstant(std::declval<NEXT_ELEMENT>()))
@@ -613,69 +951,106 @@ namespace Impl
 
     };
 
-    template <size_t OFFSET, size_t IMPLICIT_INDEX, typename PARSER, typename IO_STATE, typename DEST_PTR, typename NEXT_ELEMENT, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF(OFFSET == sizeof...(PRIMITIVES) - 1)>
-    inline bool ParseSequenceItem(Idx<OFFSET> offset, Idx<IMPLICIT_INDEX> implicitIndex, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
-        NEXT_ELEMENT const & nextElement, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence)
+    template <typename PRIMITIVE>
+    class IsIndexTag : public std::false_type
     {
-        // Seq([..., ]CurrentItem, Primitive
-        using ResolvedIndex = ResolveIndex<IMPLICIT_INDEX, NEXT_ELEMENT, SEQ_TYPE, PRIMITIVES...>;
-        return Parse(parser, Impl::FieldNotNull(ResolvedIndex(), dest), nextElement.Name(), nextElement);
-    }
+    };
 
-    template <size_t OFFSET, size_t IMPLICIT_INDEX, typename PARSER, typename IO_STATE, typename DEST_PTR, size_t EXPLICIT_INDEX, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF(OFFSET == sizeof...(PRIMITIVES) - 2)>
-    inline bool ParseSequenceItem(Idx<OFFSET> offset, Idx<IMPLICIT_INDEX> implicitIndex, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
-        Idx<EXPLICIT_INDEX> const & explicitIndex, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence)
+    template <size_t INDEX>
+    class IsIndexTag<Idx<INDEX> > : public std::true_type
     {
-        // Seq([..., ]CurrentItem, Idx<EXPLICIT_INDEX>(), Primitive)
-        enum { NEXT_OFFSET = sizeof...(PRIMITIVES) - 1 };
-        auto const & nextElement(std::get<NEXT_OFFSET>(sequence.Primitives()));
-        return Parse(parser, Impl::FieldNotNull(explicitIndex, dest), nextElement.Name(), nextElement);
-    }
+    };
 
-    template <size_t OFFSET, size_t IMPLICIT_INDEX, typename PARSER, typename IO_STATE, typename DEST_PTR, typename NEXT_ELEMENT, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF(OFFSET < sizeof...(PRIMITIVES) - 1)>
-    inline bool ParseSequenceItem(Idx<OFFSET> offset, Idx<IMPLICIT_INDEX> implicitIndex, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
-        NEXT_ELEMENT const & nextElement, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence);
+    // Whether an item takes the next implicit member: it is variable and its member isn't given by an Idx<>() before it
+    template <bool FIRST, typename PREVIOUS, typename PRIMITIVE>
+    class TakesImplicitIndex : public Bool<!IsIndexTag<PRIMITIVE>::value && (FIRST || !IsIndexTag<PREVIOUS>::value)
+        && !CONSTANT(IsConstant(std::declval<PRIMITIVE>()))>
+    {
+    };
 
-    template <size_t OFFSET, size_t IMPLICIT_INDEX, typename PARSER, typename IO_STATE, typename DEST_PTR, size_t INDEX, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF(OFFSET < sizeof...(PRIMITIVES) - 2)>
-    inline bool ParseSequenceItem(Idx<OFFSET> offset, Idx<IMPLICIT_INDEX> implicitIndex, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
-        Idx<INDEX> const & explicitIndex, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence)
+    // Member parsed by the item at POSITION of a sequence, given by the Idx<>() before it or else resolved by ResolveIndex
+    template <size_t POSITION, typename SEQ_TYPE, typename... PRIMITIVES>
+    class ItemIndex
     {
-        // Seq([..., ]CurrentItem, Idx<EXPLICIT_INDEX>(), Primitive, ...)
-        auto const & nextElement(std::get<OFFSET + 1>(sequence.Primitives()));
+        template <size_t OTHER_POSITION>
+        using Primitive = typename std::tuple_element<OTHER_POSITION, std::tuple<PRIMITIVES...> >::type;
 
-        bool result = Parse(parser, Impl::FieldNotNull(explicitIndex, dest), nextElement.Name(), nextElement);
-        if (result)
-            ioState.SetPossibleMatch();
+        template <size_t... POSITIONS>
+        static constexpr size_t ImplicitIndex(std::index_sequence<POSITIONS...>)
+        {
+            return CountFlags<1 + sizeof...(POSITIONS)>({ false,
+                TakesImplicitIndex<POSITIONS == 0, Primitive<(POSITIONS == 0 ? 0 : POSITIONS - 1)>, Primitive<POSITIONS> >::value... });
+        }
 
-        if ((SEQ_TYPE::value != SeqTypeSeq::value) || result)
-            return ParseSequenceItem(Idx<OFFSET + 2>(), implicitIndex, parser, ioState, dest,
-                std::get<OFFSET + 2>(sequence.Primitives()), sequence) || ioState.HasPossibleMatch();
-        else
-            return ioState.HasPossibleMatch();
+        template <size_t INDEX>
+        static Idx<INDEX> Resolve(Idx<INDEX>);
+
+        template <typename PREVIOUS>
+        static ResolveIndex<ImplicitIndex(std::make_index_sequence<POSITION>()), Primitive<POSITION>, SEQ_TYPE, PRIMITIVES...> Resolve(PREVIOUS);
+
+    public:
+        using Type = decltype(Resolve(std::declval<Primitive<(POSITION == 0 ? 0 : POSITION - 1)> >()));
+    };
+
+    // Position bits of the alternatives given to Prefer(), to check they are a permutation
+    template <size_t SIZE>
+    inline constexpr size_t OrderMask(size_t const (&order)[SIZE], size_t position = 0)
+    {
+        return position < SIZE ? (((size_t)1 << order[position]) | OrderMask(order, position + 1)) : 0;
     }
 
-    template <size_t OFFSET, size_t IMPLICIT_INDEX, typename PARSER, typename IO_STATE, typename DEST_PTR, typename NEXT_ELEMENT, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF_DEF(OFFSET < sizeof...(PRIMITIVES) - 1)>
-    inline bool ParseSequenceItem(Idx<OFFSET> offset, Idx<IMPLICIT_INDEX> implicitIndex, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
-        NEXT_ELEMENT const & nextElement, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence)
+    template <typename IO_STATE, typename SEQ_TYPE, typename... PRIMITIVES>
+    inline void RecordChoice(IO_STATE const & ioState, char const * ruleName, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what)
     {
-        // Seq([..., ]CurrentItem, Primitive, ...)
-        using ResolvedIndex = ResolveIndex<IMPLICIT_INDEX, NEXT_ELEMENT, SEQ_TYPE, PRIMITIVES...>;
+#ifdef PARSER_PROFILE_CHOICES
+        // only the choices making a whole rule, the ones that can be given to Prefer()
+        if (SEQ_TYPE::value != SeqTypeSeq::value && CountFlags<sizeof...(PRIMITIVES)>({ IsIndexTag<PRIMITIVES>::value... }) == 0 && std::strcmp(ruleName, what.Name()) != 0)
+            ChoiceProfile::Instance().Record(ruleName, sizeof...(PRIMITIVES), ioState.Winner());
+#else
+        (void)ioState;
+        (void)ruleName;
+        (void)what;
+#endif
+    }
 
-        bool result = Parse(parser, Impl::FieldNotNull(ResolvedIndex(), dest), nextElement.Name(), nextElement);
-        if (result)
-            ioState.SetPossibleMatch();
+    // Idx<>() tags only give the member of the next item
+    template <size_t POSITION, typename PARSER, typename IO_STATE, typename DEST_PTR, typename SEQUENCE>
+    inline bool ParseSequenceItem(std::true_type /* isIndexTag */, PARSER &, IO_STATE &, DEST_PTR, SEQUENCE const &, bool &)
+    {
+        return false;
+    }
 
-        enum
-        {
-            // Increment the implicit index, only if it was allocated by ResolveIndex
-            NEXT_IMPLICIT_INDEX = (ResolvedIndex::value == IMPLICIT_INDEX ? IMPLICIT_INDEX + 1 : IMPLICIT_INDEX)
-        };
+    // Parses the item at POSITION, returns true when no other item must be parsed
+    template <size_t POSITION, typename PARSER, typename IO_STATE, typename DEST_PTR, typename SEQ_TYPE, typename... PRIMITIVES>
+    inline bool ParseSequenceItem(std::false_type /* isIndexTag */, PARSER & parser, IO_STATE & ioState, DEST_PTR dest,
+        SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence, bool & result)
+    {
+        auto const & item(std::get<POSITION>(sequence.Primitives()));
+        ioState.BeginAlternative(POSITION);
+
+        result = ParseField(parser, Impl::FieldNotNull(typename ItemIndex<POSITION, SEQ_TYPE, PRIMITIVES...>::Type(), dest), item.Name(), item);
+        // a Cut() in this alternative commits the choice to it
+        if (ioState.TakeCut())
+            return true;
+        if (SEQ_TYPE::value == SeqTypeSeq::value)
+            return !result;
+        // the last alternative is kept by Success() if it is the longest
+        if (result && POSITION + 1 < sizeof...(PRIMITIVES))
+            ioState.SetPossibleMatch();
+        return false;
+    }
 
-        if ((SEQ_TYPE::value != SeqTypeSeq::value) || result)
-            return ParseSequenceItem(Idx<OFFSET + 1>(), Idx<NEXT_IMPLICIT_INDEX>(), parser, ioState, dest,
-                std::get<OFFSET + 1>(sequence.Primitives()), sequence) || ioState.HasPossibleMatch();
-        else
-            return ioState.HasPossibleMatch();
+    template <typename PARSER, typename IO_STATE, typename DEST_PTR, typename SEQ_TYPE, typename... PRIMITIVES, size_t... POSITIONS>
+    inline bool ParseSequenceItems(PARSER & parser, IO_STATE & ioState, DEST_PTR dest, SequenceType<SEQ_TYPE, PRIMITIVES...> const & sequence,
+        std::index_sequence<POSITIONS...>)
+    {
+        bool result(false);
+        bool stop(false);
+        // the items are parsed in order by the expansion, until one of them stops
+        bool const stops[] = { (stop = stop || ParseSequenceItem<POSITIONS>(IsIndexTag<typename std::tuple_element<POSITIONS, std::tuple<PRIMITIVES...> >::type>(),
+            parser, ioState, dest, sequence, result))... };
+        (void)stops;
+        return result || ioState.HasPossibleMatch();
     }
 }
 
@@ -683,8 +1058,54 @@ template <typename PARSER, typename DEST_PTR, typename SEQ_TYPE, typename... PRI
 inline bool Parse(PARSER & parser, DEST_PTR dest, char const * ruleName, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what)
 {
     auto ioState(parser.template Save<false, SEQ_TYPE::value != SeqTypeSeq::value>(dest, ruleName));
-    if (Impl::ParseSequenceItem(Idx<0>(), Idx<0>(), parser, ioState, dest, std::get<0>(what.Primitives()), what))
+    if (Impl::ParseSequenceItems(parser, ioState, dest, what, std::index_sequence_for<PRIMITIVES...>()))
+    {
+        Impl::RecordChoice(ioState, ruleName, what);
+        return ioState.Success();
+    }
+    return false;
+}
+
+namespace Impl
+{
+    // Parses the alternative at POSITION of a choice given to Prefer(), returns true when no other alternative must be parsed
+    template <bool FIRST_MATCH, size_t POSITION, typename PARSER, typename IO_STATE, typename DEST_PTR, typename SEQ_TYPE, typename... PRIMITIVES>
+    inline bool ParsePreferred(PARSER & parser, IO_STATE & ioState, DEST_PTR dest, SequenceType<SEQ_TYPE, PRIMITIVES...> const & choice, bool & result)
     {
+        auto const & alternative(std::get<POSITION>(choice.Primitives()));
+        ioState.BeginAlternative(POSITION);
+
+        // the same member as without Prefer()
+        result = ParseField(parser, Impl::FieldNotNull(typename ItemIndex<POSITION, SEQ_TYPE, PRIMITIVES...>::Type(), dest), alternative.Name(), alternative);
+        if (ioState.TakeCut())
+            return true;
+        if (result)
+        {
+            // nothing can be longer than the rest of the input, and on equal length the first tried wins
+            if (FIRST_MATCH || parser.AtEnd())
+                return true;
+            ioState.SetPossibleMatch();
+        }
+        return false;
+    }
+}
+
+template <typename PARSER, typename DEST_PTR, bool FIRST_MATCH, typename SEQ_TYPE, typename... PRIMITIVES, size_t... ORDER>
+inline bool Parse(PARSER & parser, DEST_PTR dest, char const * ruleName, PreferType<FIRST_MATCH, SequenceType<SEQ_TYPE, PRIMITIVES...>, ORDER...> const & what)
+{
+    static_assert(SEQ_TYPE::value != SeqTypeSeq::value, "Prefer() needs Alternatives() or Union()");
+    static_assert(Impl::CountFlags<sizeof...(PRIMITIVES)>({ Impl::IsIndexTag<PRIMITIVES>::value... }) == 0, "Prefer() doesn't support explicit Idx<>() members");
+    static_assert(sizeof...(ORDER) == sizeof...(PRIMITIVES) && sizeof...(PRIMITIVES) < 64
+        && Impl::OrderMask<sizeof...(ORDER)>({ ORDER... }) == (((size_t)1 << sizeof...(PRIMITIVES)) - 1), "Prefer() order must be a permutation of the alternatives");
+
+    auto ioState(parser.template Save<false, true>(dest, ruleName));
+    bool result(false);
+    bool stop(false);
+    bool const stops[] = { (stop = stop || Impl::ParsePreferred<FIRST_MATCH, ORDER>(parser, ioState, dest, what.Elem(), result))... };
+    (void)stops;
+    if (result || ioState.HasPossibleMatch())
+    {
+        Impl::RecordChoice(ioState, ruleName, what.Elem());
         return ioState.Success();
     }
     return false;
@@ -696,14 +1117,21 @@ inline bool Parse(PARSER & parser, ELEMS_PTR elems, char const * ruleName, Repea
     size_t count = 0;
 
     auto ioState(parser.template Save<true, false>(elems, ruleName));
+    typename PARSER::ChoicePoint choicePoint(parser);
 
     for (; count < MAX_COUNT; ++count)
     {
-        decltype(Impl::ElemTypeOrNull(elems)) elem = {};
-        if (Parse(parser, Impl::PtrOrNull(elem), what.Elem().Name(), what.Elem()))
+        auto elem(Make_Data<decltype(Impl::ElemTypeOrNull(elems))>(parser.Resource()));
+        bool parsed = Parse(parser, Impl::PtrOrNull(elem), what.Elem().Name(), what.Elem());
+        // an element failing after a Cut() fails the whole repetition instead of ending it
+        if (choicePoint.TakeCut() && !parsed)
+            return false;
+        if (parsed)
         {
             if (false == IsEmpty(elem))
                 Impl::PushBackIfNotNull(elems, std::move(elem));
+            // the repetition won't come back before this element, only fail as a whole
+            choicePoint.Advance();
         }
         else
         {
@@ -723,7 +1151,83 @@ inline bool Parse(PARSER & parser, ELEMS_PTR elems, char const * ruleName, Repea
 template <typename PARSER, typename ELEMS_PTR, typename PRIMITIVE>
 inline bool Parse(PARSER & parser, ELEMS_PTR elems, char const * ruleName, RepeatType<0, 1, PRIMITIVE> const & what)
 {
-    return Parse(parser, elems, what.Elem().Name(), what.Elem()) || true;
+    typename PARSER::ChoicePoint choicePoint(parser);
+    return Parse(parser, elems, what.Elem().Name(), what.Elem()) || !choicePoint.TakeCut();
+}
+
+template <typename PARSER, typename DEST_PTR, bool EXPECTED, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, DEST_PTR, char const * ruleName, PredicateType<EXPECTED, PRIMITIVE> const & what)
+{
+    size_t inputPos(parser.Input().Pos());
+    size_t outputPos(parser.Output().Pos());
+    std::remove_reference_t<decltype(parser.Errors())> savedErrors;
+    std::swap(savedErrors, parser.Errors());
+
+    // the input is pinned as we come back to the current position whatever the result
+    parser.Input().Pin();
+    bool matched;
+    {
+        typename PARSER::ChoicePoint choicePoint(parser);
+        matched = Parse(parser, nullptr, what.Elem().Name(), what.Elem());
+        choicePoint.TakeCut();
+    }
+    parser.Input().Unpin();
+
+    parser.Input().SetPos(inputPos);
+    parser.Output().SetPos(outputPos);
+
+    bool result(matched == EXPECTED);
+    if (result)
+    {
+        parser.Errors().clear();
+    }
+    else if (matched)
+    {
+        parser.Errors().clear();
+        parser.Errors().push_back([inputPos, elemName = what.Elem().Name()](std::ostream & cerr, std::string const & indent)
+        {
+            cerr << indent << "#" << inputPos << ": Unexpected [" << elemName << "]" << std::endl;
+        });
+    }
+    parser.Errors().insert(parser.Errors().begin(), savedErrors.begin(), savedErrors.end());
+    return result;
+}
+
+template <typename PARSER, typename DEST_PTR>
+inline bool Parse(PARSER & parser, DEST_PTR, char const * /* ruleName */, CutType const &)
+{
+    parser.Cut();
+    return true;
+}
+
+template <typename PARSER, typename DEST_PTR, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, DEST_PTR, char const * /* ruleName */, SkipType<PRIMITIVE> const & what)
+{
+    Impl::SuspendedOutput<PARSER> suspended(parser);
+    return Parse(parser, nullptr, what.Elem().Name(), what.Elem());
+}
+
+namespace Impl
+{
+    inline void SetCapture(std::nullptr_t, SubstringPos const &)
+    {
+    }
+
+    inline void SetCapture(SubstringPos * result, SubstringPos const & capture)
+    {
+        if (result != nullptr)
+            *result = capture;
+    }
+}
+
+template <typename PARSER, typename DEST_PTR, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, DEST_PTR result, char const * /* ruleName */, NoCaptureType<PRIMITIVE> const & what)
+{
+    size_t outputPos(parser.Output().Pos());
+    if (!Parse(parser, nullptr, what.Elem().Name(), what.Elem()))
+        return false;
+    Impl::SetCapture(result, SubstringPos(outputPos, parser.Output().Pos()));
+    return true;
 }
 
 #if 0
@@ -764,6 +1268,14 @@ auto DefaultData(SequenceType<SEQ_TYPE, PRIMITIVE, OTHER_PRIMITIVES...> const &
 
 #endif
 
+// Parses the definition of a rule, every use of the rule goes through it so that parsers can report the rules
+// (see ParserEvents.hpp)
+template <typename PARSER, typename TYPE, typename PRIMITIVE>
+inline bool ParseRule(PARSER & parser, TYPE result, char const * ruleName, PRIMITIVE const & definition)
+{
+    return Parse(parser, result, ruleName, definition);
+}
+
 #define PARSER_RULE_FORWARD(name) \
     class name { public: \
         static char const * Name() { return #name; } \
@@ -780,13 +1292,20 @@ auto DefaultData(SequenceType<SEQ_TYPE, PRIMITIVE, OTHER_PRIMITIVES...> const &
     class Constantness_##name : public decltype(IsConstant(__VA_ARGS__)) { }; \
     class VariablesCount_##name : public decltype(CountVariables(__VA_ARGS__)) { }; \
     template <typename PARSER, typename TYPE> \
-    inline bool Parse(PARSER & parser, TYPE result, char const *, name) { return Parse(parser, result, #name, __VA_ARGS__); } \
+    inline bool Parse(PARSER & parser, TYPE result, char const *, name) { return ParseRule(parser, result, #name, __VA_ARGS__); } \
     template <typename PARSER, typename TYPE> \
-    inline bool Parse(PARSER & parser, TYPE result, name) { return Parse(parser, result, #name, __VA_ARGS__); } \
+    inline bool Parse(PARSER & parser, TYPE result, name) { return ParseRule(parser, result, #name, __VA_ARGS__); } \
+    template <typename NFA> \
+    inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, name) \
+    { return nfa.EnterRule(#name) && nfa.LeaveRule(BuildNfa(nfa, fragment, __VA_ARGS__)); } \
+    template <typename GRAMMAR> \
+    inline size_t Describe(GRAMMAR & grammar, name) \
+    { if (grammar.DeclareRule(#name)) grammar.DefineRule(#name, Describe(grammar, __VA_ARGS__)); return grammar.RuleRef(#name); } \
+    PARSER_RULE_CONSTEXPR(name, __VA_ARGS__) \
     template <typename PARSER, typename TYPE> \
     inline bool ParseExact(PARSER & parser, TYPE result, name) \
     { \
-        if (Parse(parser, result, #name, __VA_ARGS__)) \
+        if (ParseRule(parser, result, #name, __VA_ARGS__)) \
         { \
             if (parser.Ended()) \
             { \
@@ -810,7 +1329,24 @@ auto DefaultData(SequenceType<SEQ_TYPE, PRIMITIVE, OTHER_PRIMITIVES...> const &
     template <typename PARSER> \
     bool Parse(PARSER & parser, data * result) { return Parse(parser, result, name()); } \
     template <typename PARSER> \
-    bool ParseExact(PARSER & parser, data * result) { return ParseExact(parser, result, name()); }
+    bool ParseExact(PARSER & parser, data * result) { return ParseExact(parser, result, name()); } \
+    template <typename PARSER> \
+    size_t ParsePrefix(PARSER & parser, data * result) { return ParsePrefix(parser, result, name()); }
+
+enum : size_t { PrefixNoMatch = SIZE_MAX };
+
+// Parses the rule from the current input position, without needing the input to end after it.
+// Returns the count of characters matched, PrefixNoMatch if none (the input position is then unchanged).
+// A Cut() doesn't release the input meanwhile, so that the parser can be restarted from any position after the start.
+template <typename PARSER, typename TYPE, typename RULE>
+inline size_t ParsePrefix(PARSER & parser, TYPE result, RULE const & rule)
+{
+    size_t inputPos(parser.Input().Pos());
+    parser.Input().Pin();
+    bool parsed(Parse(parser, result, rule.Name(), rule));
+    parser.Input().Unpin();
+    return parsed ? parser.Input().Pos() - inputPos : PrefixNoMatch;
+}
 
 #define PARSER_RULE(name, ...) \
     PARSER_RULE_FORWARD(name) \
@@ -823,3 +1359,4 @@ auto DefaultData(SequenceType<SEQ_TYPE, PRIMITIVE, OTHER_PRIMITIVES...> const &
 #define PARSER_RULE_DATA(name, ...) \
     PARSER_RULE_CDATA(name, name##Data, __VA_ARGS__)
 
+#include "ParserConstexpr.hpp"
@@ -0,0 +1,308 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// hashing and equality of the parsed data, by positions or by the characters they refer to, without allocation
+#pragma once
+
+#include "ParserBase.hpp"
+
+#include <cstring>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace Impl
+{
+    enum : uint64_t
+    {
+        HashP0 = 0xa0761d6478bd642full,
+        HashP1 = 0xe7037ed1a0b428dbull,
+        HashP2 = 0x8ebc6af09c88c6e3ull,
+    };
+
+    // 64 x 64 bits multiplication, both halves of the result folded together
+    inline uint64_t HashMum(uint64_t a, uint64_t b)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        uint64_t high;
+        uint64_t low(_umul128(a, b, &high));
+        return low ^ high;
+#elif defined(__SIZEOF_INT128__)
+        unsigned __int128 result((unsigned __int128)a * b);
+        return (uint64_t)result ^ (uint64_t)(result >> 64);
+#else
+        uint64_t aHigh(a >> 32), aLow((uint32_t)a), bHigh(b >> 32), bLow((uint32_t)b);
+        uint64_t middle(aHigh * bLow + (aLow * bLow >> 32));
+        uint64_t middle2(aLow * bHigh + (uint32_t)middle);
+        return (a * b) ^ (aHigh * bHigh + (middle >> 32) + (middle2 >> 32));
+#endif
+    }
+
+    inline uint64_t HashRead(uint8_t const * bytes, size_t count)
+    {
+        uint64_t value(0);
+        std::memcpy(&value, bytes, count);
+        return value;
+    }
+
+    // wyhash-like: 16 bytes per step, the tail and the length in the last one
+    inline uint64_t HashBytes(void const * data, size_t size, uint64_t seed)
+    {
+        uint8_t const * bytes(static_cast<uint8_t const *>(data));
+        seed ^= HashP0;
+        size_t left(size);
+        for (; left > 16; left -= 16, bytes += 16)
+        {
+            seed = HashMum(HashRead(bytes, 8) ^ HashP1, HashRead(bytes + 8, 8) ^ seed);
+        }
+        uint64_t a(HashRead(bytes, std::min<size_t>(left, 8)));
+        uint64_t b(left > 8 ? HashRead(bytes + 8, left - 8) : 0);
+        return HashMum(HashP1 ^ size, HashMum(a ^ HashP1, b ^ seed));
+    }
+
+    // Accumulates the hash of the parts of the data, BUFFER is std::nullptr_t to hash the positions themselves
+    template <typename BUFFER>
+    class Hasher
+    {
+        BUFFER const * buffer_;
+        uint64_t state_;
+    public:
+        inline Hasher(BUFFER const * buffer)
+            : buffer_(buffer), state_(HashP2)
+        {
+        }
+
+        inline void Add(uint64_t value)
+        {
+            state_ = HashMum(state_ ^ HashP0, value ^ HashP1);
+        }
+
+        inline void Add(SubstringPos sub)
+        {
+            AddPos(sub, buffer_);
+        }
+
+        inline uint64_t Value() const
+        {
+            return state_;
+        }
+
+    private:
+        inline void AddPos(SubstringPos const & sub, std::nullptr_t const *)
+        {
+            Add((uint64_t)sub.first);
+            Add((uint64_t)sub.second);
+        }
+
+        template <typename CHAR_TYPE, typename ALLOCATOR>
+        inline void AddPos(SubstringPos sub, std::vector<CHAR_TYPE, ALLOCATOR> const * buffer)
+        {
+            sub.first = std::min(sub.first, buffer->size());
+            sub.second = std::max(sub.first, std::min(sub.second, buffer->size()));
+            Add(HashBytes(buffer->data() + sub.first, (sub.second - sub.first) * sizeof(CHAR_TYPE), state_));
+        }
+    };
+
+    template <typename BUFFER>
+    inline void HashData(Hasher<BUFFER> & hasher, SubstringPos const & sub)
+    {
+        hasher.Add(sub);
+    }
+
+    template <typename BUFFER>
+    inline void HashData(Hasher<BUFFER> &, std::nullptr_t)
+    {
+    }
+
+    template <typename BUFFER, typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void HashData(Hasher<BUFFER> & hasher, VECTOR const & arr);
+
+    template <typename BUFFER, typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void HashData(Hasher<BUFFER> & hasher, TUPLE_TYPE const & tuple)
+    {
+        ForEachIndex<TUPLE_TYPE>([&](auto index) { HashData(hasher, std::get<decltype(index)::value>(tuple)); });
+    }
+
+    template <typename BUFFER, typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline void HashData(Hasher<BUFFER> & hasher, VECTOR const & arr)
+    {
+        hasher.Add((uint64_t)arr.size());
+        for (auto const & elem : arr)
+        {
+            HashData(hasher, elem);
+        }
+    }
+
+    // Compares the parts of two data, with the buffers they refer to or, for std::nullptr_t, by their positions
+    template <typename BUFFER1, typename BUFFER2>
+    class Comparer
+    {
+        BUFFER1 const * buffer1_;
+        BUFFER2 const * buffer2_;
+
+        static inline bool EqualPos(SubstringPos const & sub1, std::nullptr_t const *, SubstringPos const & sub2, std::nullptr_t const *)
+        {
+            return sub1 == sub2;
+        }
+
+        template <typename CHAR_TYPE, typename ALLOCATOR1, typename ALLOCATOR2>
+        static inline bool EqualPos(SubstringPos sub1, std::vector<CHAR_TYPE, ALLOCATOR1> const * buffer1,
+            SubstringPos sub2, std::vector<CHAR_TYPE, ALLOCATOR2> const * buffer2)
+        {
+            sub1.first = std::min(sub1.first, buffer1->size());
+            sub1.second = std::max(sub1.first, std::min(sub1.second, buffer1->size()));
+            sub2.first = std::min(sub2.first, buffer2->size());
+            sub2.second = std::max(sub2.first, std::min(sub2.second, buffer2->size()));
+            return sub1.second - sub1.first == sub2.second - sub2.first
+                && std::equal(buffer1->data() + sub1.first, buffer1->data() + sub1.second, buffer2->data() + sub2.first);
+        }
+    public:
+        inline Comparer(BUFFER1 const * buffer1, BUFFER2 const * buffer2)
+            : buffer1_(buffer1), buffer2_(buffer2)
+        {
+        }
+
+        inline bool operator()(SubstringPos const & sub1, SubstringPos const & sub2) const
+        {
+            return EqualPos(sub1, buffer1_, sub2, buffer2_);
+        }
+    };
+
+    template <typename COMPARER>
+    inline bool EqualData(COMPARER const & comparer, SubstringPos const & sub1, SubstringPos const & sub2)
+    {
+        return comparer(sub1, sub2);
+    }
+
+    template <typename COMPARER>
+    inline bool EqualData(COMPARER const &, std::nullptr_t, std::nullptr_t)
+    {
+        return true;
+    }
+
+    template <typename COMPARER, typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline bool EqualData(COMPARER const & comparer, VECTOR const & arr1, VECTOR const & arr2);
+
+    template <typename COMPARER, typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline bool EqualData(COMPARER const & comparer, TUPLE_TYPE const & tuple1, TUPLE_TYPE const & tuple2)
+    {
+        bool equal(true);
+        ForEachIndex<TUPLE_TYPE>([&](auto index)
+        {
+            equal = equal && EqualData(comparer, std::get<decltype(index)::value>(tuple1), std::get<decltype(index)::value>(tuple2));
+        });
+        return equal;
+    }
+
+    template <typename COMPARER, typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline bool EqualData(COMPARER const & comparer, VECTOR const & arr1, VECTOR const & arr2)
+    {
+        return arr1.size() == arr2.size() && std::equal(arr1.begin(), arr1.end(), arr2.begin(),
+            [&](auto const & elem1, auto const & elem2) { return EqualData(comparer, elem1, elem2); });
+    }
+}
+
+// Hash of the positions of the data, for the data of the same output buffer
+template <typename DATA>
+inline uint64_t Hash(DATA const & data)
+{
+    Impl::Hasher<std::nullptr_t> hasher(nullptr);
+    Impl::HashData(hasher, data);
+    return hasher.Value();
+}
+
+// Hash of the characters the data refers to: the same for the same text at other positions or in another buffer.
+// The parts are still hashed separately, "a" "bc" and "ab" "c" differ.
+template <typename DATA, typename CHAR_TYPE, typename ALLOCATOR>
+inline uint64_t Hash(DATA const & data, std::vector<CHAR_TYPE, ALLOCATOR> const & buffer)
+{
+    Impl::Hasher<std::vector<CHAR_TYPE, ALLOCATOR> > hasher(&buffer);
+    Impl::HashData(hasher, data);
+    return hasher.Value();
+}
+
+// Same positions
+template <typename DATA>
+inline bool Equal(DATA const & data1, DATA const & data2)
+{
+    return Impl::EqualData(Impl::Comparer<std::nullptr_t, std::nullptr_t>(nullptr, nullptr), data1, data2);
+}
+
+// Same characters, part by part, as Hash() with the buffers
+template <typename DATA, typename CHAR_TYPE, typename ALLOCATOR1, typename ALLOCATOR2>
+inline bool Equal(DATA const & data1, std::vector<CHAR_TYPE, ALLOCATOR1> const & buffer1,
+    DATA const & data2, std::vector<CHAR_TYPE, ALLOCATOR2> const & buffer2)
+{
+    using Comparer = Impl::Comparer<std::vector<CHAR_TYPE, ALLOCATOR1>, std::vector<CHAR_TYPE, ALLOCATOR2> >;
+    return Impl::EqualData(Comparer(&buffer1, &buffer2), data1, data2);
+}
+
+// Function objects for the unordered containers of data, by positions
+class DataHash
+{
+public:
+    template <typename DATA>
+    inline size_t operator()(DATA const & data) const
+    {
+        return (size_t)Hash(data);
+    }
+};
+
+class DataEqual
+{
+public:
+    template <typename DATA>
+    inline bool operator()(DATA const & data1, DATA const & data2) const
+    {
+        return Equal(data1, data2);
+    }
+};
+
+// By characters, for data referring to the same buffer, e.g. the output of an IncrementalParser
+template <typename BUFFER>
+class DataContentHash
+{
+    BUFFER const * buffer_;
+public:
+    inline DataContentHash(BUFFER const & buffer)
+        : buffer_(&buffer)
+    {
+    }
+
+    template <typename DATA>
+    inline size_t operator()(DATA const & data) const
+    {
+        return (size_t)Hash(data, *buffer_);
+    }
+};
+
+template <typename BUFFER>
+class DataContentEqual
+{
+    BUFFER const * buffer_;
+public:
+    inline DataContentEqual(BUFFER const & buffer)
+        : buffer_(&buffer)
+    {
+    }
+
+    template <typename DATA>
+    inline bool operator()(DATA const & data1, DATA const & data2) const
+    {
+        return Equal(data1, *buffer_, data2, *buffer_);
+    }
+};
+
+template <typename BUFFER>
+inline DataContentHash<BUFFER> Make_DataContentHash(BUFFER const & buffer)
+{
+    return DataContentHash<BUFFER>(buffer);
+}
+
+template <typename BUFFER>
+inline DataContentEqual<BUFFER> Make_DataContentEqual(BUFFER const & buffer)
+{
+    return DataContentEqual<BUFFER>(buffer);
+}
@@ -18,22 +18,23 @@ namespace Impl
     template <typename CHAR_TYPE>
     class OutputAdapter
     {
-        std::vector<CHAR_TYPE> buffer_;
+        ParserVector<CHAR_TYPE> buffer_;
         size_t bufferPos_;
+        size_t suspended_;
     public:
-        inline OutputAdapter()
-            : bufferPos_(0)
+        inline OutputAdapter(std::pmr::memory_resource * resource)
+            : buffer_(resource), bufferPos_(0), suspended_(0)
         {
         }
 
-        inline std::vector<CHAR_TYPE> const & Buffer() const
+        inline ParserVector<CHAR_TYPE> const & Buffer() const
         {
             return buffer_;
         }
 
         inline void operator()(CHAR_TYPE ch, bool isEscapeChar = false)
         {
-            if (isEscapeChar)
+            if (isEscapeChar || suspended_ > 0)
                 return;
 
             if (bufferPos_ >= buffer_.size())
@@ -48,6 +49,21 @@ namespace Impl
             bufferPos_++;
         }
 
+        // Writes count consecutive characters at once
+        template <typename INPUT_CHAR>
+        inline void Write(INPUT_CHAR const * chars, size_t count, bool isEscapeChar = false)
+        {
+            if (isEscapeChar || suspended_ > 0)
+                return;
+
+            if (bufferPos_ + count > buffer_.size())
+            {
+                buffer_.resize(bufferPos_ + count);
+            }
+            std::transform(chars, chars + count, buffer_.begin() + bufferPos_, [](INPUT_CHAR ch) { return (CHAR_TYPE)ch; });
+            bufferPos_ += count;
+        }
+
         inline size_t Pos() const
         {
             return bufferPos_;
@@ -57,6 +73,18 @@ namespace Impl
         {
             bufferPos_ = pos;
         }
+
+        // Nothing is written until the matching Resume(), see Skip()
+        inline void Suspend()
+        {
+            suspended_++;
+        }
+
+        inline void Resume()
+        {
+            assert(suspended_ > 0);
+            suspended_--;
+        }
     };
 
     template <typename INPUT>
@@ -64,32 +92,53 @@ namespace Impl
     {
         INPUT input_;
         using InputResult = decltype(std::declval<INPUT>()());
-        std::vector<InputResult> buffer_;
+        ParserVector<InputResult> buffer_;
+        size_t bufferStart_;    // position of buffer_[0], characters before it have been released
         size_t bufferPos_;
+        size_t pins_;
     public:
-        inline InputAdapter(INPUT input)
-            : input_(input), bufferPos_(0)
+        inline InputAdapter(INPUT input, std::pmr::memory_resource * resource)
+            : input_(input), buffer_(resource), bufferStart_(0), bufferPos_(0), pins_(0)
         {
         }
 
         inline MaxCharType operator()()
         {
-            if (bufferPos_ >= buffer_.size())
+            assert(bufferPos_ >= bufferStart_);
+            if (bufferPos_ - bufferStart_ >= buffer_.size())
             {
                 MaxCharType ch = (MaxCharType)input_();
                 buffer_.push_back(ch);
             }
-            assert(bufferPos_ < buffer_.size());
+            assert(bufferPos_ - bufferStart_ < buffer_.size());
 
-            return buffer_[bufferPos_++];
+            return buffer_[bufferPos_++ - bufferStart_];
         }
 
         inline void Back()
         {
-            assert(bufferPos_ > 0);
+            assert(bufferPos_ > bufferStart_);
             bufferPos_--;
         }
 
+        // Returns a window of count characters starting at the current position, reading them from the input if needed
+        inline InputResult const * Peek(size_t count)
+        {
+            assert(bufferPos_ >= bufferStart_);
+            while (bufferPos_ - bufferStart_ + count > buffer_.size())
+            {
+                MaxCharType ch = (MaxCharType)input_();
+                buffer_.push_back(ch);
+            }
+            return buffer_.data() + (bufferPos_ - bufferStart_);
+        }
+
+        inline void Skip(size_t count)
+        {
+            assert(bufferPos_ - bufferStart_ + count <= buffer_.size());
+            bufferPos_ += count;
+        }
+
         inline bool GetIf(InputResult value)
         {
             if (value == (*this)())
@@ -105,9 +154,62 @@ namespace Impl
             return bufferPos_;
         }
 
+        // A released position rewinds to the first character still in the buffer
         inline void SetPos(size_t pos)
         {
+            bufferPos_ = std::max(pos, bufferStart_);
+        }
+
+        // Position of the first character still in the buffer, the ones before have been released
+        inline size_t StartPos() const
+        {
+            return bufferStart_;
+        }
+
+        // Position after the last character read from the input: how far the parsing looked ahead
+        inline size_t ReadPos() const
+        {
+            return bufferStart_ + buffer_.size();
+        }
+
+        // Same as SetPos(), reading the input up to pos if needed.
+        // Returns false, the position unchanged, if pos has been released or is after the end of the input.
+        inline bool Seek(size_t pos)
+        {
+            if (pos < bufferStart_)
+                return false;
+            while (pos - bufferStart_ > buffer_.size())
+            {
+                MaxCharType ch = (MaxCharType)input_();
+                buffer_.push_back(ch);
+                if (ch == EOF && pos - bufferStart_ > buffer_.size())
+                    return false;
+            }
             bufferPos_ = pos;
+            return true;
+        }
+
+        // Prevents Release() while someone may still come back before the current position
+        inline void Pin()
+        {
+            pins_++;
+        }
+
+        inline void Unpin()
+        {
+            assert(pins_ > 0);
+            pins_--;
+        }
+
+        // Frees the characters before pos (at most the current position), they can't be read anymore
+        inline void Release(size_t pos)
+        {
+            pos = std::min(pos, bufferPos_);
+            if (pins_ == 0 && pos > bufferStart_)
+            {
+                buffer_.erase(buffer_.begin(), buffer_.begin() + (pos - bufferStart_));
+                bufferStart_ = pos;
+            }
         }
     };
 }
@@ -117,25 +219,101 @@ class ParserIO
 {
     using ErrorFunctionType = std::function<void(std::ostream &, std::string const &)>;
 
+    std::pmr::memory_resource * resource_;
     Impl::InputAdapter<INPUT> input_;
     Impl::OutputAdapter<CHAR_TYPE> output_;
     std::list<ErrorFunctionType> errors_;
     std::list<ErrorFunctionType> lastRepeatErrors_;
+    size_t savedStates_;
+    size_t firstSavedInputPos_;
+    size_t keepInputPos_;   // lowest position a choice point can still come back to, (size_t)-1 if none
+    bool cut_;
 public:
-    inline ParserIO(INPUT input)
-        : input_(input)
+    // The buffers and the temporary data of the parsing allocate from resource
+    inline ParserIO(INPUT input, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+        : resource_(resource), input_(input, resource), output_(resource), savedStates_(0), firstSavedInputPos_(0), keepInputPos_((size_t)-1), cut_(false)
     {
     }
 
     inline auto const & OutputBuffer() const { return output_.Buffer(); }
+    inline std::pmr::memory_resource * Resource() const { return resource_; }
     inline bool Ended() { return input_() == EOF; }
+    // Same as Ended() without consuming the character
+    inline bool AtEnd() { return *input_.Peek(1) == EOF; }
     inline Impl::InputAdapter<INPUT> & Input() { return input_; }
     inline Impl::OutputAdapter<CHAR_TYPE> & Output() { return output_; }
     inline auto const & Errors() const { return errors_; }
     inline auto & Errors() { return errors_; }
     inline auto & LastRepeatErrors() { return lastRepeatErrors_; }
 
+    // Parses again from inputPos of the same input, e.g. to look for a rule at every position with ParsePrefix().
+    // The output restarts from the beginning: results of the previous parsing must be used before.
+    // Returns false, and nothing changes, if inputPos has been released by a Cut() or is after the end of the input.
+    inline bool Restart(size_t inputPos)
+    {
+        if (!input_.Seek(inputPos))
+            return false;
+        output_.SetPos(0);
+        errors_.clear();
+        lastRepeatErrors_.clear();
+        cut_ = false;
+        return true;
+    }
+
+    // Commits the innermost choice point to the current alternative.
+    // The input before the outermost saved state is released: no state can go back before its start.
+    // Nothing is released during a parsing started at the beginning of the input, see Commit() for that.
+    inline void Cut()
+    {
+        cut_ = true;
+        if (savedStates_ > 0)
+            input_.Release(firstSavedInputPos_);
+    }
+
+    // Releases the input before the current position that no choice point can come back to, e.g. after each
+    // element given by ListEvents. The saved states that are not choice points can't rewind to it anymore:
+    // a failure after Commit() leaves the parser at the first character still in the buffer.
+    inline void Commit()
+    {
+        input_.Release(keepInputPos_);
+    }
+
 public:
+    // Alternatives, Union, Repeat and Optional are choice points: a Cut() inside one of them prevents trying another way
+    class ChoicePoint
+    {
+        ParserIO & parent_;
+        bool outerCut_;
+        size_t outerKeepInputPos_;
+    public:
+        inline ChoicePoint(ParserIO & parent)
+            : parent_(parent), outerCut_(parent.cut_), outerKeepInputPos_(parent.keepInputPos_)
+        {
+            parent_.cut_ = false;
+            parent_.keepInputPos_ = std::min(outerKeepInputPos_, parent_.Input().Pos());
+        }
+
+        inline ~ChoicePoint()
+        {
+            parent_.cut_ = outerCut_;
+            parent_.keepInputPos_ = outerKeepInputPos_;
+        }
+
+        // The choices before the current position are done, e.g. after each element of a Repeat()
+        inline void Advance()
+        {
+            parent_.keepInputPos_ = std::min(outerKeepInputPos_, parent_.Input().Pos());
+        }
+
+        // Returns true if a Cut() has been passed since the last call
+        inline bool TakeCut()
+        {
+            bool cut(parent_.cut_);
+            parent_.cut_ = false;
+            return cut;
+        }
+    };
+
     template <bool REPEAT, bool ALT, typename RESULT_PTR>
     class SavedIOState : public SavedIOState<REPEAT, ALT, std::nullptr_t>
     {
@@ -145,28 +323,33 @@ public:
         RESULT_PTR result_;
 
     private:
-        template <typename RESULT2_PTR>
-        static inline std::nullptr_t GetPreviousState(Idx<1> isRepeat, RESULT2_PTR result)
+        template <typename RESULT2, ENABLED_IF_NOT_VECTOR(RESULT2)>
+        static inline std::nullptr_t GetPreviousState(Idx<1> /* isRepeat */, RESULT2 * /* result */)
+        {
+            return nullptr;
+        }
+
+        static inline std::nullptr_t GetPreviousState(Idx<1> isRepeat, std::nullptr_t)
         {
             return nullptr;
         }
 
-        template <typename ELEM_TYPE>
-        static inline size_t GetPreviousState(Idx<1> isRepeat, std::vector<ELEM_TYPE> * result)
+        template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+        static inline size_t GetPreviousState(Idx<1> /* isRepeat */, VECTOR * result)
         {
             return result->size();
         }
 
         template <typename RESULT2_PTR>
-        static inline std::nullptr_t GetPreviousState(Idx<0> isRepeat, RESULT2_PTR result)
+        static inline std::nullptr_t GetPreviousState(Idx<0> /* isRepeat */, RESULT2_PTR /* result */)
         {
             return nullptr;
         }
 
         decltype(GetPreviousState(Idx<(size_t)REPEAT>(), result_)) previousState_;
 
-        template <typename ELEM_TYPE>
-        static inline void SetPreviousState(std::vector<ELEM_TYPE> * result, size_t previousState)
+        template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+        static inline void SetPreviousState(VECTOR * result, size_t previousState)
         {
             result->resize(previousState);
         }
@@ -174,11 +357,11 @@ public:
         template <typename RESULT>
         static inline void SetPreviousState(RESULT * result, std::nullptr_t)
         {
-            *result = {};
+            Impl::ResetData(*result);
         }
 
         template <typename RESULT2_PTR>
-        static inline void SetResult(RESULT2_PTR result, SubstringPos newResult)
+        static inline void SetResult(RESULT2_PTR /* result */, SubstringPos /* newResult */)
         {
         }
 
@@ -202,7 +385,7 @@ public:
 
         inline ~SavedIOState()
         {
-            if (this->outputPos_ != -1)
+            if (this->outputPos_ != (size_t)-1)
             {
                 Reset<false>();
             }
@@ -245,6 +428,8 @@ public:
             : parent_(parent), inputPos_(parent.Input().Pos()), outputPos_(parent.Output().Pos()),
             ruleName_(ruleName)
         {
+            if (parent_.savedStates_++ == 0)
+                parent_.firstSavedInputPos_ = inputPos_;
             std::swap(savedErrors_, parent.Errors());
         }
 
@@ -257,6 +442,7 @@ public:
 
         inline ~SavedIOState()
         {
+            parent_.savedStates_--;
             if (inputPos_ != (size_t)-1 && outputPos_ != (size_t)-1)
             {
                 std::list<ErrorFunctionType> childErrors;
@@ -297,6 +483,22 @@ public:
             return false;
         }
 
+        inline void BeginAlternative(size_t /* index */)
+        {
+        }
+
+#ifdef PARSER_PROFILE_CHOICES
+        inline size_t Winner() const
+        {
+            return 0;
+        }
+#endif
+
+        inline bool TakeCut()
+        {
+            return false;
+        }
+
     protected:
         inline std::nullptr_t Result()
         {
@@ -311,16 +513,23 @@ public:
         size_t bestLength_ = 0;
         size_t bestOutputPos_ = 0;
         size_t bestInputPos_ = 0;
+        ChoicePoint choicePoint_;
+        bool committed_ = false;
+#ifdef PARSER_PROFILE_CHOICES
+        size_t alternativeIndex_ = 0;
+        size_t bestAlternativeIndex_ = 0;
+#endif
 
         static inline std::nullptr_t SaveAlternative(std::nullptr_t, std::nullptr_t)
         {
             return nullptr;
         }
 
+        // The source is reset after, moving keeps the memory resource of the vectors that a copy wouldn't
         template <typename RESULT>
         static inline RESULT & SaveAlternative(RESULT * destination, RESULT * source)
         {
-            return *destination = *source;
+            return *destination = std::move(*source);
         }
 
         std::remove_reference_t<decltype(SaveAlternative(std::declval<RESULT_PTR>(), std::declval<RESULT_PTR>()))> bestAlternative_;
@@ -346,14 +555,38 @@ public:
                 bestOutputPos_ = this->parent_.Output().Pos();
                 bestInputPos_ = this->parent_.Input().Pos();
                 SaveAlternative(PtrToBestAlternative(bestAlternative_), this->Result());
-                // resets to the initial state to parse another alternative
-                this->template Reset<true>();
+#ifdef PARSER_PROFILE_CHOICES
+                bestAlternativeIndex_ = alternativeIndex_;
+#endif
             }
+            // resets to the initial state to parse another alternative, even after a shorter match
+            this->template Reset<true>();
         }
 
         inline bool HasPossibleMatch() const
         {
-            return bestLength_ > 0;
+            return !committed_ && bestLength_ > 0;
+        }
+
+#ifdef PARSER_PROFILE_CHOICES
+        inline void BeginAlternative(size_t index)
+        {
+            alternativeIndex_ = index;
+        }
+
+        // Position in the choice of the alternative kept by Success()
+        inline size_t Winner() const
+        {
+            return (this->parent_.Input().Pos() - this->inputPos_ < bestLength_) ? bestAlternativeIndex_ : alternativeIndex_;
+        }
+#endif
+
+        // Once committed by a Cut(), no other alternative is tried and the previous ones can't be used on failure
+        inline bool TakeCut()
+        {
+            if (choicePoint_.TakeCut())
+                committed_ = true;
+            return committed_;
         }
 
         inline bool Success()
@@ -369,8 +602,9 @@ public:
         }
     public:
         inline SavedIOState(ParserIO & parent, RESULT_PTR result, char const * ruleName)
-            : Base(parent, result, ruleName)
+            : Base(parent, result, ruleName), choicePoint_(parent)
         {
+            Impl::UseResource(bestAlternative_, parent.Resource());
         }
     };
 
@@ -382,29 +616,106 @@ public:
 };
 
 template <typename INPUT, typename CHAR_TYPE>
-inline ParserIO<INPUT, CHAR_TYPE> Make_Parser(INPUT && input, CHAR_TYPE charType)
+inline ParserIO<INPUT, CHAR_TYPE> Make_Parser(INPUT && input, CHAR_TYPE /* charType */,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
 {
-    return ParserIO<INPUT, CHAR_TYPE>(input);
+    return ParserIO<INPUT, CHAR_TYPE>(input, resource);
 }
 
-template <typename CHAR_TYPE>
-inline auto Make_ParserFromStream(std::basic_istream<CHAR_TYPE> & is)
+namespace Impl
 {
-    return Make_Parser([&] () mutable
+    // Inputs have a name, so that the parsers using them can be compiled once in a library (see rfc5322/RFC5322Parser.hpp)
+    template <typename CHAR_TYPE>
+    class StreamInput
+    {
+        std::basic_istream<CHAR_TYPE> * is_;
+    public:
+        inline StreamInput(std::basic_istream<CHAR_TYPE> & is)
+            : is_(&is)
+        {
+        }
+
+        inline auto operator()()
+        {
+            return is_->get();
+        }
+    };
+
+    template <typename CHAR_TYPE>
+    class StringInput
     {
-        return is.get();
-    }, (CHAR_TYPE)0);
+        std::basic_string<CHAR_TYPE> str_;
+        size_t pos_;
+    public:
+        inline StringInput(std::basic_string<CHAR_TYPE> const & str)
+            : str_(str), pos_(0)
+        {
+        }
+
+        inline int operator()()
+        {
+            if (pos_ < str_.size())
+            {
+                return (int)str_[pos_++];
+            }
+            return EOF;
+        }
+    };
 }
 
-template <typename CHAR_TYPE>
-inline auto Make_ParserFromString(std::basic_string<CHAR_TYPE> const & str)
+namespace Impl
 {
-    return Make_Parser([=, pos = (size_t)0] () mutable
+    // Reads characters owned by the caller, see ParserIncremental.hpp
+    template <typename CHAR_TYPE>
+    class ViewInput
     {
-        if (pos < str.size())
+        CHAR_TYPE const * chars_;
+        size_t size_;
+        size_t pos_;
+    public:
+        inline ViewInput(CHAR_TYPE const * chars, size_t size)
+            : chars_(chars), size_(size), pos_(0)
         {
-            return (int)str[pos++];
         }
-        return EOF;
-    }, (CHAR_TYPE)0);
+
+        inline int operator()()
+        {
+            if (pos_ < size_)
+            {
+                return (int)chars_[pos_++];
+            }
+            return EOF;
+        }
+    };
+}
+
+template <typename CHAR_TYPE>
+using StreamParserIO = ParserIO<Impl::StreamInput<CHAR_TYPE>, CHAR_TYPE>;
+
+template <typename CHAR_TYPE>
+using StringParserIO = ParserIO<Impl::StringInput<CHAR_TYPE>, CHAR_TYPE>;
+
+template <typename CHAR_TYPE>
+using ViewParserIO = ParserIO<Impl::ViewInput<CHAR_TYPE>, CHAR_TYPE>;
+
+template <typename CHAR_TYPE>
+inline StreamParserIO<CHAR_TYPE> Make_ParserFromStream(std::basic_istream<CHAR_TYPE> & is,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+{
+    return Make_Parser(Impl::StreamInput<CHAR_TYPE>(is), (CHAR_TYPE)0, resource);
+}
+
+template <typename CHAR_TYPE>
+inline StringParserIO<CHAR_TYPE> Make_ParserFromString(std::basic_string<CHAR_TYPE> const & str,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+{
+    return Make_Parser(Impl::StringInput<CHAR_TYPE>(str), (CHAR_TYPE)0, resource);
+}
+
+// The characters must outlive the parser
+template <typename CHAR_TYPE>
+inline ViewParserIO<CHAR_TYPE> Make_ParserFromView(CHAR_TYPE const * chars, size_t size,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+{
+    return Make_Parser(Impl::ViewInput<CHAR_TYPE>(chars, size), (CHAR_TYPE)0, resource);
 }
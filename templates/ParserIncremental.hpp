@@ -0,0 +1,269 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// incremental parsing of the lists (address-list, rulelist) of large texts being edited
+#pragma once
+
+#include "ParserGrammar.hpp"
+#include "ParserIO.hpp"
+
+namespace Impl
+{
+    // Moves the positions of the data in the output buffer, backward when offset wraps around.
+    // The null positions of the parts not parsed stay null.
+
+    inline void OffsetOutput(SubstringPos & sub, size_t offset)
+    {
+        if (IsNull(sub))
+            return;
+        sub.first += offset;
+        sub.second += offset;
+    }
+
+    inline void OffsetOutput(std::nullptr_t, size_t /* offset */)
+    {
+    }
+
+    template <typename VECTOR, ENABLED_IF_VECTOR(VECTOR)>
+    inline void OffsetOutput(VECTOR & arr, size_t offset);
+
+    template <typename TUPLE_TYPE, ENABLED_IF_TUPLISH(TUPLE_TYPE)>
+    inline void OffsetOutput(TUPLE_TYPE & tuple, size_t offset)
+    {
+        ForEachIndex<TUPLE_TYPE>([&](auto index) { OffsetOutput(std::get<decltype(index)::value>(tuple), offset); });
+    }
+
+    template <typename VECTOR, ENABLED_IF_VECTOR_DEF(VECTOR)>
+    inline void OffsetOutput(VECTOR & arr, size_t offset)
+    {
+        for (auto & elem : arr)
+        {
+            OffsetOutput(elem, offset);
+        }
+    }
+
+    template <typename PARSER>
+    inline bool ParseSeparator(PARSER &, std::nullptr_t)
+    {
+        return true;
+    }
+
+    template <typename PARSER, typename SEPARATOR>
+    inline bool ParseSeparator(PARSER & parser, SEPARATOR const & separator)
+    {
+        return ParsePrefix(parser, nullptr, separator) != PrefixNoMatch;
+    }
+}
+
+// Keeps the data of a list, ELEM (SEPARATOR ELEM)*, up to date with the edits of its text.
+// The text is split in chunks, each parsed ELEM and the SEPARATOR before it. An edit parses again from the first chunk
+// whose parsing read the edited characters, until a chunk starts where an old one after the edit started: the
+// following ones are kept. The output buffer only grows until a compaction, the data keeps pointing into it.
+// While the text is invalid, the chunks after the first error aren't kept.
+template <typename LIST_DATA, typename ELEM, typename SEPARATOR = std::nullptr_t, typename CHAR_TYPE = char>
+class IncrementalParser
+{
+    using ElemData = typename LIST_DATA::value_type;
+
+    class Chunk
+    {
+    public:
+        size_t Begin;
+        size_t End;
+        size_t ReadEnd;     // the parsing of the chunks up to this one read the characters before ReadEnd
+        size_t OutputBegin;
+        size_t OutputEnd;
+        bool HasData;       // elements giving an empty data, like the empty lines of a rulelist, aren't in the list
+    };
+
+    ELEM elem_;
+    SEPARATOR separator_;
+    std::basic_string<CHAR_TYPE> text_;
+    std::vector<Chunk> chunks_;
+    LIST_DATA data_;
+    ParserVector<CHAR_TYPE> output_;
+    size_t usedOutput_ = 0;
+    size_t lastParsed_ = 0;
+
+    size_t DataIndex(size_t chunkIndex) const
+    {
+        return std::count_if(chunks_.begin(), chunks_.begin() + chunkIndex, [](Chunk const & chunk) { return chunk.HasData; });
+    }
+
+    // Parses the chunks from chunkIndex, the text after editEnd (before the edit) being moved by delta
+    bool Reparse(size_t chunkIndex, size_t editEnd, ptrdiff_t delta)
+    {
+        size_t begin(chunkIndex < chunks_.size() ? chunks_[chunkIndex].Begin : (chunks_.empty() ? 0 : chunks_.back().End));
+        auto parser(Make_ParserFromView(text_.data() + begin, text_.size() - begin));
+        // as for a whole parsing, only the start of the text can give empty positions at 0, that look null
+        size_t outputStart(begin > 0 ? 1 : 0);
+        if (outputStart > 0)
+        {
+            parser.Output()(CHAR_TYPE());
+        }
+
+        std::vector<Chunk> newChunks;
+        LIST_DATA newData;
+        size_t keptIndex(chunkIndex);
+        size_t pos(begin);
+        for (;;)
+        {
+            // an old chunk after the edit starting here is parsed the same way, with the ones after it
+            while (keptIndex < chunks_.size() && (chunks_[keptIndex].Begin < editEnd || chunks_[keptIndex].Begin + delta < pos))
+                ++keptIndex;
+            if (!newChunks.empty() && keptIndex > 0 && keptIndex < chunks_.size() && chunks_[keptIndex].Begin + delta == pos)
+                break;
+
+            size_t chunkPos(parser.Input().Pos());
+            size_t outputPos(parser.Output().Pos());
+            ElemData elem = {};
+            if ((chunkIndex + newChunks.size() > 0 && !Impl::ParseSeparator(parser, separator_))
+                || ParsePrefix(parser, &elem, elem_) == PrefixNoMatch)
+            {
+                parser.Input().SetPos(chunkPos);
+                keptIndex = chunks_.size();
+                break;
+            }
+            size_t end(begin + parser.Input().Pos());
+            newChunks.push_back({ pos, end, begin + parser.Input().ReadPos(), outputPos, parser.Output().Pos(), false == IsEmpty(elem) });
+            if (newChunks.back().HasData)
+            {
+                newData.push_back(std::move(elem));
+            }
+            if (end == pos && std::is_same<SEPARATOR, std::nullptr_t>::value)
+            {
+                // an empty element would be parsed forever
+                keptIndex = chunks_.size();
+                break;
+            }
+            pos = end;
+        }
+        lastParsed_ = parser.Input().ReadPos();
+
+        // the new output goes after the current one
+        size_t outputOffset(output_.size() - outputStart);
+        for (auto & newChunk : newChunks)
+        {
+            newChunk.OutputBegin += outputOffset;
+            newChunk.OutputEnd += outputOffset;
+            usedOutput_ += newChunk.OutputEnd - newChunk.OutputBegin;
+        }
+        for (auto & elem : newData)
+        {
+            Impl::OffsetOutput(elem, outputOffset);
+        }
+        output_.insert(output_.end(), parser.OutputBuffer().begin() + outputStart, parser.OutputBuffer().begin() + parser.Output().Pos());
+
+        // replaces the chunks from chunkIndex to keptIndex
+        size_t dataIndex(DataIndex(chunkIndex));
+        size_t keptDataIndex(DataIndex(keptIndex));
+        for (size_t index = chunkIndex; index < keptIndex; ++index)
+        {
+            usedOutput_ -= chunks_[index].OutputEnd - chunks_[index].OutputBegin;
+        }
+        for (size_t index = keptIndex; index < chunks_.size(); ++index)
+        {
+            chunks_[index].Begin += delta;
+            chunks_[index].End += delta;
+            chunks_[index].ReadEnd += delta;
+        }
+        data_.erase(data_.begin() + dataIndex, data_.begin() + keptDataIndex);
+        data_.insert(data_.begin() + dataIndex, std::make_move_iterator(newData.begin()), std::make_move_iterator(newData.end()));
+        chunks_.erase(chunks_.begin() + chunkIndex, chunks_.begin() + keptIndex);
+        chunks_.insert(chunks_.begin() + chunkIndex, newChunks.begin(), newChunks.end());
+
+        // ReadEnd stays sorted for the search of the first chunk to parse again, a greater one only parses more
+        for (size_t index = std::max<size_t>(chunkIndex, 1); index < chunks_.size(); ++index)
+        {
+            if (chunks_[index].ReadEnd < chunks_[index - 1].ReadEnd)
+                chunks_[index].ReadEnd = chunks_[index - 1].ReadEnd;
+            else if (index >= chunkIndex + newChunks.size())
+                break;
+        }
+
+        if (output_.size() > 2 * usedOutput_ + 4096)
+        {
+            CompactOutput();
+        }
+        return Valid();
+    }
+
+    // Removes the output of the replaced chunks
+    void CompactOutput()
+    {
+        // same memory resource, for the swap
+        ParserVector<CHAR_TYPE> output(output_.get_allocator());
+        output.reserve(usedOutput_);
+        auto elemPtr(data_.begin());
+        for (auto & chunk : chunks_)
+        {
+            size_t outputBegin(output.size());
+            output.insert(output.end(), output_.begin() + chunk.OutputBegin, output_.begin() + chunk.OutputEnd);
+            if (chunk.HasData)
+            {
+                Impl::OffsetOutput(*elemPtr++, outputBegin - chunk.OutputBegin);
+            }
+            chunk.OutputBegin = outputBegin;
+            chunk.OutputEnd = output.size();
+        }
+        std::swap(output, output_);
+    }
+
+public:
+    inline IncrementalParser(ELEM elem = ELEM(), SEPARATOR separator = SEPARATOR())
+        : elem_(elem), separator_(separator)
+    {
+    }
+
+    // Parses a whole new text
+    bool Reset(std::basic_string<CHAR_TYPE> text)
+    {
+        text_ = std::move(text);
+        chunks_.clear();
+        data_.clear();
+        output_.clear();
+        usedOutput_ = 0;
+        return Reparse(0, 0, 0);
+    }
+
+    // Replaces removedCount characters at offset by the inserted ones, returns Valid()
+    bool Edit(size_t offset, size_t removedCount, std::basic_string<CHAR_TYPE> const & inserted)
+    {
+        assert(offset + removedCount <= text_.size());
+        text_.replace(offset, removedCount, inserted);
+
+        // the chunks whose parsing didn't read the edited characters stay the same
+        auto chunkPtr(std::upper_bound(chunks_.begin(), chunks_.end(), offset, [](size_t offset, Chunk const & chunk) { return offset < chunk.ReadEnd; }));
+        return Reparse(chunkPtr - chunks_.begin(), offset + removedCount, (ptrdiff_t)inserted.size() - (ptrdiff_t)removedCount);
+    }
+
+    // True if the whole text is the list, as ParseExact() would tell
+    inline bool Valid() const
+    {
+        return !chunks_.empty() && chunks_.back().End == text_.size();
+    }
+
+    inline std::basic_string<CHAR_TYPE> const & Text() const
+    {
+        return text_;
+    }
+
+    // Only relevant when Valid()
+    inline LIST_DATA const & Data() const
+    {
+        return data_;
+    }
+
+    inline ParserVector<CHAR_TYPE> const & OutputBuffer() const
+    {
+        return output_;
+    }
+
+    // Count of characters read by the last Reset() or Edit()
+    inline size_t LastParsed() const
+    {
+        return lastParsed_;
+    }
+};
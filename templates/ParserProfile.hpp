@@ -0,0 +1,76 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// profile of the alternatives chosen by the rules, to order them with Prefer()
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Impl
+{
+    // Number of wins of each alternative, for each rule made of a choice
+    // Filled when PARSER_PROFILE_CHOICES is defined
+    class ChoiceProfile
+    {
+        std::map<std::string, std::vector<size_t> > wins_;
+    public:
+        static ChoiceProfile & Instance()
+        {
+            static ChoiceProfile profile;
+            return profile;
+        }
+
+        void Record(char const * ruleName, size_t alternativesCount, size_t winner)
+        {
+            auto & wins(wins_[ruleName]);
+            wins.resize(alternativesCount);
+            if (winner < alternativesCount)
+                wins[winner]++;
+        }
+
+        std::map<std::string, std::vector<size_t> > const & Wins() const
+        {
+            return wins_;
+        }
+
+        void Clear()
+        {
+            wins_.clear();
+        }
+    };
+}
+
+// Writes, for each of the profiled rules given, its alternatives from the most to the least frequent winner:
+//  #define <macroPrefix><rule> 1, 0
+// The generated header is meant to be included by the rules, that use the macros as Prefer<...>() orders
+inline void WriteChoiceOrder(std::ostream & os, char const * macroPrefix, std::initializer_list<char const *> ruleNames)
+{
+    os << "// Generated by WriteChoiceOrder() from a parse of a training corpus with PARSER_PROFILE_CHOICES" << std::endl;
+    for (auto const & rule : Impl::ChoiceProfile::Instance().Wins())
+    {
+        if (std::none_of(ruleNames.begin(), ruleNames.end(), [&](char const * ruleName) { return rule.first == ruleName; }))
+            continue;
+
+        std::vector<size_t> order(rule.second.size());
+        for (size_t index = 0; index < order.size(); ++index)
+            order[index] = index;
+        // on equal counts, the order of the grammar is kept
+        std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right) { return rule.second[left] > rule.second[right]; });
+
+        os << std::endl << "// " << rule.first << " wins:";
+        for (size_t count : rule.second)
+            os << " " << count;
+        os << std::endl << "#define " << macroPrefix << rule.first << " ";
+        for (size_t index = 0; index < order.size(); ++index)
+            os << (index > 0 ? ", " : "") << order[index];
+        os << std::endl;
+    }
+}
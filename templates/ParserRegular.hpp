@@ -0,0 +1,619 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// lowering of regular sub-grammars into table driven DFAs
+#pragma once
+
+#include "ParserGrammar.hpp"
+#include <bitset>
+#include <map>
+
+// Regular matches the primitive with a minimized DFA instead of the recursive engine.
+// The primitive must describe a regular language: no recursion, predicate nor cut. Otherwise, or when its result
+// is structured (not a SubstringPos), parsing falls back to the primitive itself.
+// The DFA matches the longest prefix in the language of the primitive, use it where the engine wouldn't need to
+// backtrack into a repetition to match (ie. 1*atext *("." 1*atext)).
+template <typename PRIMITIVE>
+class RegularType
+{
+    PRIMITIVE primitive_;
+public:
+    inline RegularType(PRIMITIVE primitive)
+        : primitive_(primitive)
+    {
+    }
+
+    static char const * Name() { return "Regular"; }
+
+    inline constexpr PRIMITIVE const & Elem() const { return primitive_; }
+    inline PRIMITIVE & Elem() { return primitive_; }
+};
+
+template <typename PRIMITIVE>
+inline RegularType<PRIMITIVE> Regular(PRIMITIVE primitive)
+{
+    return RegularType<PRIMITIVE>(primitive);
+}
+
+namespace Impl
+{
+    template <typename PRIMITIVE>
+    class Constantness<RegularType<PRIMITIVE> > : public Constantness<PRIMITIVE>
+    {
+    };
+
+    // Thompson's construction of a non deterministic automaton over bytes
+    class Nfa
+    {
+    public:
+        using CharSet = std::bitset<256>;
+        using Fragment = std::pair<size_t, size_t>;    // start state, accepting state
+
+        enum { MaxRepeatExpansion = 64 };
+
+        class State
+        {
+        public:
+            std::vector<size_t> Epsilons;
+            std::vector<std::pair<CharSet, size_t> > Transitions;
+        };
+
+    private:
+        std::vector<State> states_;
+        std::vector<char const *> rules_;
+
+    public:
+        inline std::vector<State> const & States() const
+        {
+            return states_;
+        }
+
+        inline size_t NewState()
+        {
+            states_.emplace_back();
+            return states_.size() - 1;
+        }
+
+        inline Fragment Empty()
+        {
+            size_t state(NewState());
+            return Fragment(state, state);
+        }
+
+        // Fragment that doesn't match anything, the neutral element of Alternate
+        inline Fragment Nothing()
+        {
+            return Fragment(NewState(), NewState());
+        }
+
+        inline Fragment Chars(CharSet const & chars)
+        {
+            Fragment fragment(NewState(), NewState());
+            states_[fragment.first].Transitions.emplace_back(chars, fragment.second);
+            return fragment;
+        }
+
+        // fragment = fragment next
+        inline void Concat(Fragment & fragment, Fragment const & next)
+        {
+            states_[fragment.second].Epsilons.push_back(next.first);
+            fragment.second = next.second;
+        }
+
+        // fragment = fragment / other
+        inline void Alternate(Fragment & fragment, Fragment const & other)
+        {
+            Fragment result(NewState(), NewState());
+            states_[result.first].Epsilons.push_back(fragment.first);
+            states_[result.first].Epsilons.push_back(other.first);
+            states_[fragment.second].Epsilons.push_back(result.second);
+            states_[other.second].Epsilons.push_back(result.second);
+            fragment = result;
+        }
+
+        // fragment = [fragment]
+        inline void Optional(Fragment & fragment)
+        {
+            states_[fragment.first].Epsilons.push_back(fragment.second);
+        }
+
+        // fragment = *fragment
+        inline void Star(Fragment & fragment)
+        {
+            Fragment result(NewState(), NewState());
+            states_[result.first].Epsilons.push_back(fragment.first);
+            states_[result.first].Epsilons.push_back(result.second);
+            states_[fragment.second].Epsilons.push_back(fragment.first);
+            states_[fragment.second].Epsilons.push_back(result.second);
+            fragment = result;
+        }
+
+        // A rule already being lowered is recursive, so not regular
+        inline bool EnterRule(char const * name)
+        {
+            if (std::find(rules_.begin(), rules_.end(), name) != rules_.end())
+                return false;
+            rules_.push_back(name);
+            return true;
+        }
+
+        inline bool LeaveRule(bool result)
+        {
+            rules_.pop_back();
+            return result;
+        }
+    };
+
+    // Minimized deterministic automaton, the state 0 is the dead state
+    class Dfa
+    {
+        enum { MaxStates = 4096 };
+
+        std::vector<size_t> transitions_;   // states x classes
+        std::vector<bool> accepting_;
+        unsigned char classes_[256];
+        size_t classCount_ = 0;
+        size_t start_ = 0;
+        bool valid_ = false;
+
+        static inline void Closure(Nfa const & nfa, std::vector<size_t> & states)
+        {
+            std::vector<size_t> pending(states);
+            std::vector<bool> visited(nfa.States().size());
+            for (size_t state : states)
+                visited[state] = true;
+            while (!pending.empty())
+            {
+                size_t state(pending.back());
+                pending.pop_back();
+                for (size_t next : nfa.States()[state].Epsilons)
+                {
+                    if (!visited[next])
+                    {
+                        visited[next] = true;
+                        states.push_back(next);
+                        pending.push_back(next);
+                    }
+                }
+            }
+            std::sort(states.begin(), states.end());
+        }
+
+        // Bytes that no transition distinguishes share the same column
+        inline void ComputeClasses(Nfa const & nfa)
+        {
+            std::map<std::vector<bool>, unsigned char> classOfSignature;
+            for (size_t ch = 0; ch < 256; ++ch)
+            {
+                std::vector<bool> signature;
+                for (auto const & state : nfa.States())
+                {
+                    for (auto const & transition : state.Transitions)
+                        signature.push_back(transition.first[ch]);
+                }
+                auto inserted(classOfSignature.emplace(signature, (unsigned char)classOfSignature.size()));
+                classes_[ch] = inserted.first->second;
+            }
+            classCount_ = classOfSignature.size();
+        }
+
+    public:
+        inline Dfa()
+        {
+            std::fill(std::begin(classes_), std::end(classes_), (unsigned char)0);
+        }
+
+        inline Dfa(Nfa const & nfa, Nfa::Fragment const & fragment)
+            : Dfa()
+        {
+            ComputeClasses(nfa);
+
+            std::vector<unsigned char> representative(classCount_);
+            for (size_t ch = 256; ch-- > 0;)
+                representative[classes_[ch]] = (unsigned char)ch;
+
+            // Subset construction, the empty set is the dead state 0
+            std::map<std::vector<size_t>, size_t> stateOfSet;
+            std::vector<std::vector<size_t> > sets(1);
+            std::vector<size_t> table;
+            stateOfSet.emplace(sets[0], 0);
+
+            std::vector<size_t> startSet(1, fragment.first);
+            Closure(nfa, startSet);
+            stateOfSet.emplace(startSet, 1);
+            sets.push_back(startSet);
+
+            for (size_t dfaState = 0; dfaState < sets.size(); ++dfaState)
+            {
+                if (sets.size() > MaxStates)
+                    return;
+
+                for (size_t charClass = 0; charClass < classCount_; ++charClass)
+                {
+                    std::vector<size_t> nextSet;
+                    for (size_t nfaState : sets[dfaState])
+                    {
+                        for (auto const & transition : nfa.States()[nfaState].Transitions)
+                        {
+                            if (transition.first[representative[charClass]])
+                                nextSet.push_back(transition.second);
+                        }
+                    }
+                    std::sort(nextSet.begin(), nextSet.end());
+                    nextSet.erase(std::unique(nextSet.begin(), nextSet.end()), nextSet.end());
+                    Closure(nfa, nextSet);
+
+                    auto inserted(stateOfSet.emplace(nextSet, sets.size()));
+                    if (inserted.second)
+                        sets.push_back(nextSet);
+                    table.push_back(inserted.first->second);
+                }
+            }
+
+            // Moore's partition refinement, starting from accepting / non accepting states
+            std::vector<size_t> block(sets.size());
+            for (size_t state = 0; state < sets.size(); ++state)
+                block[state] = std::binary_search(sets[state].begin(), sets[state].end(), fragment.second) ? 1 : 0;
+
+            for (size_t blockCount = 0;;)
+            {
+                std::map<std::vector<size_t>, size_t> blockOfSignature;
+                std::vector<size_t> newBlock(sets.size());
+                for (size_t state = 0; state < sets.size(); ++state)
+                {
+                    std::vector<size_t> signature(1, block[state]);
+                    for (size_t charClass = 0; charClass < classCount_; ++charClass)
+                        signature.push_back(block[table[state * classCount_ + charClass]]);
+                    newBlock[state] = blockOfSignature.emplace(signature, blockOfSignature.size()).first->second;
+                }
+                block.swap(newBlock);
+                if (blockOfSignature.size() == blockCount)
+                    break;
+                blockCount = blockOfSignature.size();
+            }
+
+            // Renumber the blocks so that the dead state stays 0
+            std::vector<size_t> renumbered(sets.size(), (size_t)-1);
+            std::vector<size_t> stateOfBlock;
+            auto renumber = [&](size_t state)
+            {
+                if (renumbered[block[state]] == (size_t)-1)
+                {
+                    renumbered[block[state]] = stateOfBlock.size();
+                    stateOfBlock.push_back(state);
+                }
+                return renumbered[block[state]];
+            };
+            renumber(0);
+            start_ = renumber(1);
+            for (size_t state = 0; state < sets.size(); ++state)
+                renumber(state);
+
+            transitions_.resize(stateOfBlock.size() * classCount_);
+            accepting_.resize(stateOfBlock.size());
+            for (size_t state = 0; state < stateOfBlock.size(); ++state)
+            {
+                size_t original(stateOfBlock[state]);
+                accepting_[state] = std::binary_search(sets[original].begin(), sets[original].end(), fragment.second);
+                for (size_t charClass = 0; charClass < classCount_; ++charClass)
+                    transitions_[state * classCount_ + charClass] = renumber(table[original * classCount_ + charClass]);
+            }
+            valid_ = true;
+        }
+
+        inline bool Valid() const
+        {
+            return valid_;
+        }
+
+        inline size_t StatesCount() const
+        {
+            return accepting_.size();
+        }
+
+        // Returns the length of the longest match from the current input position, or -1
+        template <typename INPUT>
+        inline size_t Match(INPUT & input) const
+        {
+            size_t state(start_);
+            size_t length(0);
+            size_t matchLength(accepting_[state] ? 0 : (size_t)-1);
+            for (;;)
+            {
+                MaxCharType ch(input());
+                if (ch < 0 || ch > 0xFF)
+                    break;
+                state = transitions_[state * classCount_ + classes_[ch]];
+                if (state == 0)
+                    break;
+                ++length;
+                if (accepting_[state])
+                    matchLength = length;
+            }
+            return matchLength;
+        }
+    };
+
+    template <size_t CH1, size_t CH2>
+    inline bool AddRange(Nfa::CharSet & chars)
+    {
+        if (CH1 > CH2 || CH2 > 0xFF)
+            return false;
+        for (size_t ch = CH1; ch <= CH2; ++ch)
+            chars.set(ch);
+        return true;
+    }
+}
+
+// Lowering of the primitives into the NFA, returns false if the primitive is not regular
+
+// Primitives without a lowering are left to the recursive engine. The DFA copies all it matches to the output, it
+// can't lower the primitives whose Parse() drops characters with escape = true.
+template <typename NFA, typename PRIMITIVE>
+inline bool BuildNfa(NFA &, typename NFA::Fragment &, PRIMITIVE const &)
+{
+    return false;
+}
+
+template <typename NFA, size_t INDEX>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, Idx<INDEX>)
+{
+    fragment = nfa.Empty();
+    return true;
+}
+
+template <typename NFA, MaxCharType... CODES>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, CharVal<CODES...>)
+{
+    typename NFA::CharSet chars;
+    bool const valid[] = { Impl::AddRange<(size_t)CODES, (size_t)CODES>(chars)... };
+    fragment = nfa.Chars(chars);
+    return std::find(std::begin(valid), std::end(valid), false) == std::end(valid);
+}
+
+template <typename NFA, MaxCharType CH1, MaxCharType CH2>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, CharRange<CH1, CH2>)
+{
+    typename NFA::CharSet chars;
+    if (!Impl::AddRange<(size_t)CH1, (size_t)CH2>(chars))
+        return false;
+    fragment = nfa.Chars(chars);
+    return true;
+}
+
+template <typename NFA, MaxCharType... CODES>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, Literal<CODES...>)
+{
+    fragment = nfa.Empty();
+    bool const valid[] = { (CODES >= 0 && CODES <= 0xFF)... };
+    for (MaxCharType code : { CODES... })
+    {
+        typename NFA::CharSet chars;
+        chars.set((unsigned char)code);
+        nfa.Concat(fragment, nfa.Chars(chars));
+    }
+    return std::find(std::begin(valid), std::end(valid), false) == std::end(valid);
+}
+
+template <typename NFA, MaxCharType... CODES>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, ILiteral<CODES...>)
+{
+    fragment = nfa.Empty();
+    bool const valid[] = { (CODES >= 0 && CODES <= 0xFF)... };
+    for (MaxCharType code : { CODES... })
+    {
+        typename NFA::CharSet chars;
+        chars.set((unsigned char)code);
+        chars.set((unsigned char)(code ^ Impl::CaseFoldMask(code)));
+        nfa.Concat(fragment, nfa.Chars(chars));
+    }
+    return std::find(std::begin(valid), std::end(valid), false) == std::end(valid);
+}
+
+template <typename NFA, bool EXPECTED, typename PRIMITIVE>
+inline bool BuildNfa(NFA &, typename NFA::Fragment &, PredicateType<EXPECTED, PRIMITIVE> const &)
+{
+    return false;
+}
+
+template <typename NFA>
+inline bool BuildNfa(NFA &, typename NFA::Fragment &, CutType const &)
+{
+    return false;
+}
+
+// The order of the alternatives doesn't change the language, nor keeping the first match since PreferFirst() is only
+// given alternatives that can't match at the same position
+template <typename NFA, bool FIRST_MATCH, typename CHOICE, size_t... ORDER>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, PreferType<FIRST_MATCH, CHOICE, ORDER...> const & what)
+{
+    return BuildNfa(nfa, fragment, what.Elem());
+}
+
+template <typename NFA, typename PRIMITIVE>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, RegularType<PRIMITIVE> const & what)
+{
+    return BuildNfa(nfa, fragment, what.Elem());
+}
+
+// The DFA writes all it matches
+template <typename NFA, typename PRIMITIVE>
+inline bool BuildNfa(NFA &, typename NFA::Fragment &, SkipType<PRIMITIVE> const &)
+{
+    return false;
+}
+
+template <typename NFA, typename PRIMITIVE>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, NoCaptureType<PRIMITIVE> const & what)
+{
+    return BuildNfa(nfa, fragment, what.Elem());
+}
+
+namespace Impl
+{
+    template <size_t INDEX>
+    std::true_type IsIndex(Idx<INDEX>);
+
+    template <typename PRIMITIVE>
+    std::false_type IsIndex(PRIMITIVE const &);
+
+    template <typename NFA, typename SEQ_TYPE, typename... PRIMITIVES>
+    inline bool BuildNfaItems(Idx<sizeof...(PRIMITIVES)>, NFA &, typename NFA::Fragment &, SequenceType<SEQ_TYPE, PRIMITIVES...> const &)
+    {
+        return true;
+    }
+
+    template <size_t OFFSET, typename NFA, typename SEQ_TYPE, typename... PRIMITIVES, ENABLED_IF(OFFSET < sizeof...(PRIMITIVES))>
+    inline bool BuildNfaItems(Idx<OFFSET>, NFA & nfa, typename NFA::Fragment & fragment, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what)
+    {
+        auto const & primitive(std::get<OFFSET>(what.Primitives()));
+        // Indices only direct the results
+        if (false == CONSTANT(IsIndex(primitive)))
+        {
+            typename NFA::Fragment next;
+            if (!BuildNfa(nfa, next, primitive))
+                return false;
+            if (std::is_same<SEQ_TYPE, SeqTypeSeq>::value)
+                nfa.Concat(fragment, next);
+            else
+                nfa.Alternate(fragment, next);
+        }
+        return BuildNfaItems(Idx<OFFSET + 1>(), nfa, fragment, what);
+    }
+}
+
+template <typename NFA, typename SEQ_TYPE, typename... PRIMITIVES>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, SequenceType<SEQ_TYPE, PRIMITIVES...> const & what)
+{
+    if (std::is_same<SEQ_TYPE, SeqTypeSeq>::value)
+        fragment = nfa.Empty();
+    else
+        fragment = nfa.Nothing();
+    return Impl::BuildNfaItems(Idx<0>(), nfa, fragment, what);
+}
+
+template <typename NFA, size_t MIN_COUNT, size_t MAX_COUNT, typename PRIMITIVE>
+inline bool BuildNfa(NFA & nfa, typename NFA::Fragment & fragment, RepeatType<MIN_COUNT, MAX_COUNT, PRIMITIVE> const & what)
+{
+    if (MIN_COUNT > NFA::MaxRepeatExpansion || (MAX_COUNT != SIZE_MAX && MAX_COUNT > NFA::MaxRepeatExpansion))
+        return false;
+
+    fragment = nfa.Empty();
+    for (size_t count = 0; count < MIN_COUNT; ++count)
+    {
+        typename NFA::Fragment elem;
+        if (!BuildNfa(nfa, elem, what.Elem()))
+            return false;
+        nfa.Concat(fragment, elem);
+    }
+
+    if (MAX_COUNT == SIZE_MAX)
+    {
+        typename NFA::Fragment elem;
+        if (!BuildNfa(nfa, elem, what.Elem()))
+            return false;
+        nfa.Star(elem);
+        nfa.Concat(fragment, elem);
+    }
+    else
+    {
+        for (size_t count = MIN_COUNT; count < MAX_COUNT; ++count)
+        {
+            typename NFA::Fragment elem;
+            if (!BuildNfa(nfa, elem, what.Elem()))
+                return false;
+            nfa.Optional(elem);
+            nfa.Concat(fragment, elem);
+        }
+    }
+    return true;
+}
+
+namespace Impl
+{
+    // The DFA of a primitive is built on first use
+    template <typename PRIMITIVE>
+    inline Dfa const & DfaFor(PRIMITIVE const & primitive)
+    {
+        static Dfa const dfa([&]
+        {
+            Nfa nfa;
+            Nfa::Fragment fragment;
+            if (BuildNfa(nfa, fragment, primitive))
+                return Dfa(nfa, fragment);
+            return Dfa();
+        }());
+        return dfa;
+    }
+
+    template <typename PARSER>
+    inline void SetRegularResult(PARSER &, std::nullptr_t, size_t)
+    {
+    }
+
+    template <typename PARSER>
+    inline void SetRegularResult(PARSER & parser, SubstringPos * result, size_t outputPos)
+    {
+        if (result != nullptr)
+            *result = SubstringPos(outputPos, parser.Output().Pos());
+    }
+
+    template <typename PARSER, typename RESULT_PTR, typename PRIMITIVE>
+    inline bool ParseRegular(PARSER & parser, RESULT_PTR result, char const * ruleName, RegularType<PRIMITIVE> const & what)
+    {
+        auto const & dfa(DfaFor(what.Elem()));
+        if (!dfa.Valid())
+            return Parse(parser, result, ruleName, what.Elem());
+
+        size_t inputPos(parser.Input().Pos());
+        size_t length(dfa.Match(parser.Input()));
+        parser.Input().SetPos(inputPos);
+        if (length == (size_t)-1)
+        {
+            parser.Errors().push_back([inputPos, ruleName](std::ostream & cerr, std::string const & indent)
+            {
+                cerr << indent << "#" << inputPos << ": Error parsing rule [" << ruleName << "]" << std::endl;
+            });
+            return false;
+        }
+
+        size_t outputPos(parser.Output().Pos());
+        parser.Output().Write(parser.Input().Peek(length), length);
+        parser.Input().Skip(length);
+        SetRegularResult(parser, result, outputPos);
+        return true;
+    }
+}
+
+template <typename PARSER, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, std::nullptr_t, char const * ruleName, RegularType<PRIMITIVE> const & what)
+{
+    return Impl::ParseRegular(parser, nullptr, ruleName, what);
+}
+
+template <typename PARSER, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, SubstringPos * result, char const * ruleName, RegularType<PRIMITIVE> const & what)
+{
+    return Impl::ParseRegular(parser, result, ruleName, what);
+}
+
+#ifdef PARSER_CONSTEXPR_MATCH
+namespace Impl
+{
+    // Regular() is meant for primitives the recursive engine matches the same way
+    template <typename PRIMITIVE>
+    constexpr ConstMatchResult ConstMatch(ConstInput input, size_t pos, TypeTag<RegularType<PRIMITIVE> >)
+    {
+        return ConstMatch(input, pos, TypeTag<PRIMITIVE>());
+    }
+}
+#endif
+
+// Structured results need the captures of the recursive engine
+template <typename PARSER, typename RESULT_PTR, typename PRIMITIVE>
+inline bool Parse(PARSER & parser, RESULT_PTR result, char const * ruleName, RegularType<PRIMITIVE> const & what)
+{
+    return Parse(parser, result, ruleName, what.Elem());
+}
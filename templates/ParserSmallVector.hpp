@@ -0,0 +1,293 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// vector keeping its first elements inline, for the short lists of the parsed data
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Same interface as the std::vector subset the parsers use. The first INLINE_COUNT elements are stored in the object,
+// the allocator is only used past them: a display name of a few words or a group of one mailbox doesn't allocate.
+template <typename TYPE, size_t INLINE_COUNT, typename ALLOCATOR = std::allocator<TYPE> >
+class SmallVector
+{
+    static_assert(INLINE_COUNT > 0, "SmallVector needs at least one inline element");
+
+    using AllocatorTraits = std::allocator_traits<ALLOCATOR>;
+
+    typename std::aligned_storage<sizeof(TYPE), alignof(TYPE)>::type inline_[INLINE_COUNT];
+    TYPE * data_;
+    size_t size_;
+    size_t capacity_;
+    ALLOCATOR allocator_;
+
+    inline TYPE * InlineData()
+    {
+        return reinterpret_cast<TYPE *>(inline_);
+    }
+
+    inline bool IsInline() const
+    {
+        return data_ == reinterpret_cast<TYPE const *>(inline_);
+    }
+
+    // The elements are constructed and destroyed by the allocator, as in a std::vector: a std::pmr allocator gives
+    // them its memory resource
+    template <typename ITERATOR>
+    inline void ConstructAll(ITERATOR first, ITERATOR last, TYPE * dest)
+    {
+        for (; first != last; ++first, ++dest)
+        {
+            AllocatorTraits::construct(allocator_, dest, *first);
+        }
+    }
+
+    inline void Grow(size_t minCapacity)
+    {
+        size_t newCapacity(std::max(minCapacity, 2 * capacity_));
+        TYPE * newData(AllocatorTraits::allocate(allocator_, newCapacity));
+        ConstructAll(std::make_move_iterator(data_), std::make_move_iterator(data_ + size_), newData);
+        DestroyAll();
+        data_ = newData;
+        capacity_ = newCapacity;
+    }
+
+    inline void DestroyAll()
+    {
+        for (size_t index = 0; index < size_; ++index)
+        {
+            AllocatorTraits::destroy(allocator_, data_ + index);
+        }
+        if (!IsInline())
+        {
+            AllocatorTraits::deallocate(allocator_, data_, capacity_);
+        }
+    }
+
+    // Takes the elements of other, that is left empty
+    inline void Steal(SmallVector & other)
+    {
+        if (other.IsInline())
+        {
+            ConstructAll(std::make_move_iterator(other.data_), std::make_move_iterator(other.data_ + other.size_), data_);
+            size_ = other.size_;
+            other.clear();
+        }
+        else
+        {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.InlineData();
+            other.size_ = 0;
+            other.capacity_ = INLINE_COUNT;
+        }
+    }
+
+    inline void MoveAssign(SmallVector & other, std::true_type /* propagate */)
+    {
+        allocator_ = other.allocator_;
+        Steal(other);
+    }
+
+    inline void MoveAssign(SmallVector & other, std::false_type /* propagate */)
+    {
+        if (allocator_ == other.allocator_)
+        {
+            Steal(other);
+        }
+        else
+        {
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+            other.clear();
+        }
+    }
+
+    template <typename OTHER>
+    inline void CopyAllocator(OTHER const & other, std::true_type /* propagate */)
+    {
+        allocator_ = other;
+    }
+
+    template <typename OTHER>
+    inline void CopyAllocator(OTHER const & /* other */, std::false_type /* propagate */)
+    {
+    }
+
+public:
+    using value_type = TYPE;
+    using allocator_type = ALLOCATOR;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = TYPE &;
+    using const_reference = TYPE const &;
+    using pointer = TYPE *;
+    using const_pointer = TYPE const *;
+    using iterator = TYPE *;
+    using const_iterator = TYPE const *;
+
+    inline SmallVector()
+        : data_(InlineData()), size_(0), capacity_(INLINE_COUNT), allocator_()
+    {
+    }
+
+    inline explicit SmallVector(ALLOCATOR const & allocator)
+        : data_(InlineData()), size_(0), capacity_(INLINE_COUNT), allocator_(allocator)
+    {
+    }
+
+    inline SmallVector(std::initializer_list<TYPE> elems)
+        : SmallVector()
+    {
+        assign(elems.begin(), elems.end());
+    }
+
+    inline SmallVector(SmallVector const & other)
+        : data_(InlineData()), size_(0), capacity_(INLINE_COUNT),
+        allocator_(AllocatorTraits::select_on_container_copy_construction(other.allocator_))
+    {
+        assign(other.begin(), other.end());
+    }
+
+    // noexcept so that the vectors of SmallVectors move them when they grow, instead of copying them without their allocator
+    inline SmallVector(SmallVector && other) noexcept(std::is_nothrow_move_constructible<TYPE>::value)
+        : data_(InlineData()), size_(0), capacity_(INLINE_COUNT), allocator_(other.allocator_)
+    {
+        Steal(other);
+    }
+
+    inline ~SmallVector()
+    {
+        DestroyAll();
+    }
+
+    inline SmallVector & operator=(SmallVector const & other)
+    {
+        if (this != &other)
+        {
+            if (AllocatorTraits::propagate_on_container_copy_assignment::value && allocator_ != other.allocator_)
+            {
+                // the elements must be freed by the allocator they come from
+                DestroyAll();
+                data_ = InlineData();
+                size_ = 0;
+                capacity_ = INLINE_COUNT;
+            }
+            CopyAllocator(other.allocator_, typename AllocatorTraits::propagate_on_container_copy_assignment());
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    inline SmallVector & operator=(SmallVector && other)
+    {
+        if (this != &other)
+        {
+            DestroyAll();
+            data_ = InlineData();
+            size_ = 0;
+            capacity_ = INLINE_COUNT;
+            MoveAssign(other, typename AllocatorTraits::propagate_on_container_move_assignment());
+        }
+        return *this;
+    }
+
+    template <typename ITERATOR>
+    inline void assign(ITERATOR first, ITERATOR last)
+    {
+        clear();
+        size_t count(std::distance(first, last));
+        reserve(count);
+        ConstructAll(first, last, data_);
+        size_ = count;
+    }
+
+    inline allocator_type get_allocator() const { return allocator_; }
+
+    inline iterator begin() { return data_; }
+    inline iterator end() { return data_ + size_; }
+    inline const_iterator begin() const { return data_; }
+    inline const_iterator end() const { return data_ + size_; }
+    inline size_t size() const { return size_; }
+    inline size_t capacity() const { return capacity_; }
+    inline bool empty() const { return size_ == 0; }
+    inline TYPE * data() { return data_; }
+    inline TYPE const * data() const { return data_; }
+    inline TYPE & operator[](size_t index) { return data_[index]; }
+    inline TYPE const & operator[](size_t index) const { return data_[index]; }
+    inline TYPE & front() { return data_[0]; }
+    inline TYPE const & front() const { return data_[0]; }
+    inline TYPE & back() { return data_[size_ - 1]; }
+    inline TYPE const & back() const { return data_[size_ - 1]; }
+
+    inline void reserve(size_t capacity)
+    {
+        if (capacity > capacity_)
+            Grow(capacity);
+    }
+
+    template <typename... ARGS>
+    inline TYPE & emplace_back(ARGS &&... args)
+    {
+        if (size_ == capacity_)
+        {
+            // args may refer to an element moved by Grow()
+            TYPE elem(std::forward<ARGS>(args)...);
+            Grow(size_ + 1);
+            AllocatorTraits::construct(allocator_, data_ + size_, std::move(elem));
+        }
+        else
+        {
+            AllocatorTraits::construct(allocator_, data_ + size_, std::forward<ARGS>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    inline void push_back(TYPE const & elem)
+    {
+        emplace_back(elem);
+    }
+
+    inline void push_back(TYPE && elem)
+    {
+        emplace_back(std::move(elem));
+    }
+
+    inline void pop_back()
+    {
+        AllocatorTraits::destroy(allocator_, data_ + --size_);
+    }
+
+    // Keeps the capacity, as the repetitions shrink back to their previous size on failure
+    inline void resize(size_t size)
+    {
+        while (size_ > size)
+            pop_back();
+        reserve(size);
+        while (size_ < size)
+            emplace_back();
+    }
+
+    inline void clear()
+    {
+        resize(0);
+    }
+
+    inline bool operator==(SmallVector const & other) const
+    {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+
+    inline bool operator!=(SmallVector const & other) const
+    {
+        return !(*this == other);
+    }
+};
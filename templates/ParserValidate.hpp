@@ -0,0 +1,371 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// validation only parsing: Validate<RFC5322::AddrSpec>(address) tells if the whole input matches the rule,
+// without output, results, errors nor allocation
+#pragma once
+
+#include "ParserBase.hpp"
+
+#include <string>
+
+namespace Impl
+{
+    // Reads the characters in place, nothing is buffered
+    template <typename CHAR_TYPE>
+    class ViewInputAdapter
+    {
+        CHAR_TYPE const * chars_;
+        size_t size_;
+        size_t pos_;
+    public:
+        inline ViewInputAdapter(CHAR_TYPE const * chars, size_t size)
+            : chars_(chars), size_(size), pos_(0)
+        {
+        }
+
+        // As InputAdapter, EOF is read past the end and the position still moves
+        inline MaxCharType operator()()
+        {
+            size_t pos(pos_++);
+            return pos < size_ ? (MaxCharType)chars_[pos] : EOF;
+        }
+
+        inline void Back()
+        {
+            assert(pos_ > 0);
+            pos_--;
+        }
+
+        // Returns nullptr if less than count characters remain
+        inline CHAR_TYPE const * Peek(size_t count) const
+        {
+            return pos_ <= size_ && count <= size_ - pos_ ? chars_ + pos_ : nullptr;
+        }
+
+        inline void Skip(size_t count)
+        {
+            assert(pos_ + count <= size_);
+            pos_ += count;
+        }
+
+        inline bool AtEnd() const
+        {
+            return pos_ >= size_;
+        }
+
+        inline size_t Size() const
+        {
+            return size_;
+        }
+
+        inline size_t Pos() const
+        {
+            return pos_;
+        }
+
+        inline void SetPos(size_t pos)
+        {
+            pos_ = pos;
+        }
+
+        // Everything stays readable
+        inline void Pin()
+        {
+        }
+
+        inline void Unpin()
+        {
+        }
+
+        inline void Release(size_t /* pos */)
+        {
+        }
+    };
+
+    class NullOutputAdapter
+    {
+    public:
+        template <typename INPUT_CHAR>
+        inline void operator()(INPUT_CHAR /* ch */, bool /* isEscapeChar */ = false)
+        {
+        }
+
+        template <typename INPUT_CHAR>
+        inline void Write(INPUT_CHAR const * /* chars */, size_t /* count */, bool /* isEscapeChar */ = false)
+        {
+        }
+
+        inline size_t Pos() const
+        {
+            return 0;
+        }
+
+        inline void SetPos(size_t /* pos */)
+        {
+        }
+
+        inline void Suspend()
+        {
+        }
+
+        inline void Resume()
+        {
+        }
+    };
+
+    // Errors are dropped as soon as they are reported
+    class NullErrors
+    {
+    public:
+        template <typename ERROR_FUNCTION>
+        inline void push_back(ERROR_FUNCTION &&)
+        {
+        }
+
+        inline std::nullptr_t begin() const
+        {
+            return nullptr;
+        }
+
+        inline std::nullptr_t end() const
+        {
+            return nullptr;
+        }
+
+        template <typename ITERATOR>
+        inline void insert(std::nullptr_t, ITERATOR, ITERATOR)
+        {
+        }
+
+        inline void clear()
+        {
+        }
+    };
+}
+
+// Same interface as ParserIO for the Parse() functions, with only the input positions kept by the saved states
+template <typename CHAR_TYPE>
+class ValidatorIO
+{
+    Impl::ViewInputAdapter<CHAR_TYPE> input_;
+    Impl::NullOutputAdapter output_;
+    Impl::NullErrors errors_;
+    bool cut_;
+public:
+    inline ValidatorIO(CHAR_TYPE const * chars, size_t size)
+        : input_(chars, size), cut_(false)
+    {
+    }
+
+    inline bool Ended() { return input_() == EOF; }
+    inline bool AtEnd() { return input_.AtEnd(); }
+    inline Impl::ViewInputAdapter<CHAR_TYPE> & Input() { return input_; }
+    inline Impl::NullOutputAdapter & Output() { return output_; }
+    inline Impl::NullErrors & Errors() { return errors_; }
+    inline Impl::NullErrors & LastRepeatErrors() { return errors_; }
+
+    // Validates again from inputPos, see ParserIO::Restart(). Nothing is released, only the positions after the end fail.
+    inline bool Restart(size_t inputPos)
+    {
+        if (inputPos > input_.Size())
+            return false;
+        input_.SetPos(inputPos);
+        cut_ = false;
+        return true;
+    }
+
+    inline void Cut()
+    {
+        cut_ = true;
+    }
+
+    // The whole input stays readable
+    inline void Commit()
+    {
+    }
+
+    // Nothing is built
+    inline std::pmr::memory_resource * Resource() const
+    {
+        return std::pmr::get_default_resource();
+    }
+
+    class ChoicePoint
+    {
+        ValidatorIO & parent_;
+        bool outerCut_;
+    public:
+        inline ChoicePoint(ValidatorIO & parent)
+            : parent_(parent), outerCut_(parent.cut_)
+        {
+            parent_.cut_ = false;
+        }
+
+        inline ~ChoicePoint()
+        {
+            parent_.cut_ = outerCut_;
+        }
+
+        inline void Advance()
+        {
+        }
+
+        inline bool TakeCut()
+        {
+            bool cut(parent_.cut_);
+            parent_.cut_ = false;
+            return cut;
+        }
+    };
+
+    template <bool REPEAT, bool ALT>
+    class SavedIOState
+    {
+    protected:
+        ValidatorIO & parent_;
+        size_t inputPos_;
+    public:
+        inline SavedIOState(ValidatorIO & parent)
+            : parent_(parent), inputPos_(parent.Input().Pos())
+        {
+        }
+
+        template <bool WHOLE>
+        inline void Reset()
+        {
+            parent_.Input().SetPos(inputPos_);
+        }
+
+        inline ~SavedIOState()
+        {
+            if (inputPos_ != (size_t)-1)
+            {
+                Reset<false>();
+            }
+        }
+
+        inline bool Success()
+        {
+            inputPos_ = (size_t)-1;
+            return true;
+        }
+
+        inline void SetPossibleMatch() const
+        {
+        }
+
+        inline bool HasPossibleMatch() const
+        {
+            return false;
+        }
+
+        inline void BeginAlternative(size_t /* index */)
+        {
+        }
+
+#ifdef PARSER_PROFILE_CHOICES
+        inline size_t Winner() const
+        {
+            return 0;
+        }
+#endif
+
+        inline bool TakeCut()
+        {
+            return false;
+        }
+    };
+
+    // The longest alternative is kept as by ParserIO, only its end is saved
+    template <bool REPEAT>
+    class SavedIOState<REPEAT, true> : public SavedIOState<false, false>
+    {
+        using Base = SavedIOState<false, false>;
+        size_t bestInputPos_ = 0;
+        ChoicePoint choicePoint_;
+        bool committed_ = false;
+#ifdef PARSER_PROFILE_CHOICES
+        size_t alternativeIndex_ = 0;
+        size_t bestAlternativeIndex_ = 0;
+#endif
+    public:
+        inline SavedIOState(ValidatorIO & parent)
+            : Base(parent), bestInputPos_(parent.Input().Pos()), choicePoint_(parent)
+        {
+        }
+
+        inline void SetPossibleMatch()
+        {
+            if (this->parent_.Input().Pos() > bestInputPos_)
+            {
+                bestInputPos_ = this->parent_.Input().Pos();
+#ifdef PARSER_PROFILE_CHOICES
+                bestAlternativeIndex_ = alternativeIndex_;
+#endif
+            }
+            this->template Reset<true>();
+        }
+
+        inline bool HasPossibleMatch() const
+        {
+            return !committed_ && bestInputPos_ > this->inputPos_;
+        }
+
+#ifdef PARSER_PROFILE_CHOICES
+        inline void BeginAlternative(size_t index)
+        {
+            alternativeIndex_ = index;
+        }
+
+        inline size_t Winner() const
+        {
+            return (this->parent_.Input().Pos() < bestInputPos_) ? bestAlternativeIndex_ : alternativeIndex_;
+        }
+#endif
+
+        inline bool TakeCut()
+        {
+            if (choicePoint_.TakeCut())
+                committed_ = true;
+            return committed_;
+        }
+
+        inline bool Success()
+        {
+            if (this->parent_.Input().Pos() < bestInputPos_)
+            {
+                this->parent_.Input().SetPos(bestInputPos_);
+            }
+            return Base::Success();
+        }
+    };
+
+    template <bool REPEAT, bool ALT>
+    inline SavedIOState<REPEAT, ALT> Save(std::nullptr_t, char const * /* ruleName */)
+    {
+        return SavedIOState<REPEAT, ALT>(*this);
+    }
+};
+
+// True if the whole input matches the rule, as ParseExact() would
+template <typename RULE, typename CHAR_TYPE>
+inline bool Validate(CHAR_TYPE const * chars, size_t size)
+{
+    ValidatorIO<CHAR_TYPE> validator(chars, size);
+    return ParseExact(validator, nullptr, RULE());
+}
+
+template <typename RULE, typename CHAR_TYPE>
+inline bool Validate(std::basic_string<CHAR_TYPE> const & str)
+{
+    return Validate<RULE>(str.data(), str.size());
+}
+
+template <typename RULE, typename CHAR_TYPE>
+inline bool Validate(std::basic_string_view<CHAR_TYPE> str)
+{
+    return Validate<RULE>(str.data(), str.size());
+}
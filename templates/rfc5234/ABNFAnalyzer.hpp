@@ -0,0 +1,98 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// static analysis of ABNF grammars loaded at runtime
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+
+#include "ParserAnalyzer.hpp"
+#include "ABNFGrammar.hpp"
+
+namespace ABNFMachine
+{
+    namespace Impl
+    {
+        inline size_t Describe(GrammarAnalyzer & grammar, Node const & node, std::map<std::string, Node> const & nodes)
+        {
+            switch (node.Kind)
+            {
+            case Node::Chars:
+                return grammar.Chars(node.Set);
+            case Node::String:
+            {
+                std::vector<size_t> chars;
+                for (char ch : node.Text)
+                {
+                    GrammarAnalyzer::CharSet set;
+                    set.set((unsigned char)ch);
+                    if (node.CaseInsensitive && std::isalpha((unsigned char)ch))
+                        set.set((unsigned char)ch ^ 0x20);
+                    chars.push_back(grammar.Chars(set));
+                }
+                return grammar.Sequence(chars);
+            }
+            case Node::Concatenation:
+            case Node::Alternation:
+            {
+                std::vector<size_t> children;
+                for (auto const & child : node.Children)
+                    children.push_back(Describe(grammar, child, nodes));
+                // Same semantic as Alternatives: the longest alternative wins
+                return node.Kind == Node::Concatenation ? grammar.Sequence(children) : grammar.Choice(children);
+            }
+            case Node::Repetition:
+                return grammar.Repeat(node.Min, node.Max, Describe(grammar, node.Children.front(), nodes));
+            case Node::RuleRef:
+            {
+                auto ruleEntryPtr(nodes.find(node.Text));
+                if (grammar.DeclareRule(node.Text) && ruleEntryPtr != nodes.end())
+                    grammar.DefineRule(node.Text, Describe(grammar, ruleEntryPtr->second, nodes));
+                return grammar.RuleRef(node.Text);
+            }
+            }
+            return grammar.Empty();
+        }
+    }
+
+    // Analysis of the rules parsed by RFC5234ABNF::rulelist, the core rules are added when used unless redefined
+    inline bool Analyze(GrammarAnalyzer & grammar, RFC5234ABNF::RuleListData const & rules, ParserVector<char> const & buffer, std::vector<std::string> & errors)
+    {
+        size_t errorsCount(errors.size());
+        std::map<std::string, Impl::Node> nodes(Impl::CoreRules());
+        std::map<std::string, Impl::Node> ownNodes;
+        Impl::Converter(buffer, errors).AddRules(rules, ownNodes);
+        for (auto & rule : ownNodes)
+            nodes[rule.first] = rule.second;
+
+        for (auto const & rule : ownNodes)
+        {
+            Impl::Node ruleRef;
+            ruleRef.Kind = Impl::Node::RuleRef;
+            ruleRef.Text = rule.first;
+            Impl::Describe(grammar, ruleRef, nodes);
+        }
+        grammar.Analyze();
+        return errors.size() == errorsCount;
+    }
+
+    // Parse and analyze ABNF rules
+    inline bool Analyze(GrammarAnalyzer & grammar, std::string const & abnf, std::vector<std::string> & errors)
+    {
+        auto parser(Make_ParserFromString(abnf));
+        RFC5234ABNF::RuleListData rules;
+        if (RFC5234ABNF::ParseExact(parser, &rules))
+            return Analyze(grammar, rules, parser.OutputBuffer(), errors);
+
+        std::stringstream ss;
+        for (auto const & parseError : parser.Errors())
+        {
+            parseError(ss, "");
+        }
+        errors.push_back(ss.str());
+        return false;
+    }
+}
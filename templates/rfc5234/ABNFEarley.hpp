@@ -0,0 +1,392 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// Earley recognizer for ABNF grammars loaded at runtime
+#pragma once
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+
+#include "ABNFGrammar.hpp"
+
+namespace ABNFMachine
+{
+    namespace Impl
+    {
+        // Recognizes any context free grammar, including ambiguous ones, in O(n^3) time and O(n^2) space at worst
+        // (O(n^2) for unambiguous grammars, mostly linear for the usual ones).
+        // Rules are lowered into productions whose right hand sides are made of nonterminals and character classes.
+        // Nullable nonterminals are handled when predicted (Aycock & Horspool).
+        class EarleyGrammar
+        {
+        public:
+            // Nonterminals are >= 0, terminals are ~(index of the character class)
+            using Symbol = int32_t;
+
+        private:
+            enum { MaxRepeatExpansion = 255 };
+
+            class Production
+            {
+            public:
+                Symbol Lhs;
+                std::vector<Symbol> Rhs;
+            };
+
+            class Item
+            {
+            public:
+                uint32_t Production;
+                uint32_t Dot;
+                uint32_t Origin;
+            };
+
+            // Set of items of the positions being built, open addressing on the packed items
+            class ItemTable
+            {
+                enum : uint64_t { Empty = UINT64_MAX };
+                std::vector<uint64_t> slots_ = std::vector<uint64_t>(64, (uint64_t)Empty);
+                size_t count_ = 0;
+
+                void Grow()
+                {
+                    std::vector<uint64_t> slots(slots_.size() * 2, (uint64_t)Empty);
+                    std::swap(slots, slots_);
+                    for (auto key : slots)
+                    {
+                        if (key != Empty)
+                            Insert(key);
+                    }
+                }
+
+            public:
+                void Clear()
+                {
+                    std::fill(slots_.begin(), slots_.end(), (uint64_t)Empty);
+                    count_ = 0;
+                }
+
+                // Returns false if already there
+                bool Insert(uint64_t key)
+                {
+                    if ((count_ + 1) * 2 > slots_.size())
+                        Grow();
+                    size_t mask(slots_.size() - 1);
+                    for (size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask; ; slot = (slot + 1) & mask)
+                    {
+                        if (slots_[slot] == key)
+                            return false;
+                        if (slots_[slot] == Empty)
+                        {
+                            slots_[slot] = key;
+                            ++count_;
+                            return true;
+                        }
+                    }
+                }
+            };
+
+            // Items of one input position, and once the position is done, the items waiting for each nonterminal
+            class ItemSet
+            {
+            public:
+                std::vector<Item> Items;
+                std::vector<std::pair<Symbol, uint32_t> > Waiting;
+            };
+
+            std::vector<Production> productions_;
+            std::vector<uint64_t> firstDottedRule_;    // number of the dotted rule of each production with the dot first
+            uint64_t dottedRules_ = 0;
+            std::vector<std::vector<uint32_t> > byLhs_;
+            std::vector<bool> nullable_;
+            std::vector<CharSet> sets_;
+            std::map<std::string, Symbol> rules_;
+            std::map<std::string, Node> const * nodes_ = nullptr;
+            std::vector<std::string> * errors_ = nullptr;
+
+            Symbol NewNonterminal()
+            {
+                byLhs_.emplace_back();
+                return (Symbol)byLhs_.size() - 1;
+            }
+
+            void AddProduction(Symbol lhs, std::vector<Symbol> rhs)
+            {
+                byLhs_[lhs].push_back((uint32_t)productions_.size());
+                firstDottedRule_.push_back(dottedRules_);
+                dottedRules_ += rhs.size() + 1;
+                productions_.push_back({ lhs, std::move(rhs) });
+            }
+
+            Symbol Terminal(CharSet const & set)
+            {
+                auto setPtr(std::find(sets_.begin(), sets_.end(), set));
+                if (setPtr == sets_.end())
+                {
+                    sets_.push_back(set);
+                    return ~(Symbol)(sets_.size() - 1);
+                }
+                return ~(Symbol)(setPtr - sets_.begin());
+            }
+
+            Symbol Build(Node const & node)
+            {
+                // Character classes, including rules like ALPHA, are single terminals
+                CharSet set;
+                if (node.Kind != Node::Chars && ToCharSet(node, *nodes_, set))
+                    return Terminal(set);
+
+                switch (node.Kind)
+                {
+                case Node::Chars:
+                    return Terminal(node.Set);
+                case Node::String:
+                {
+                    std::vector<Symbol> rhs;
+                    for (char ch : node.Text)
+                    {
+                        CharSet set;
+                        set.set((unsigned char)ch);
+                        if (node.CaseInsensitive && std::isalpha((unsigned char)ch))
+                            set.set((unsigned char)ch ^ 0x20);
+                        rhs.push_back(Terminal(set));
+                    }
+                    Symbol lhs(NewNonterminal());
+                    AddProduction(lhs, std::move(rhs));
+                    return lhs;
+                }
+                case Node::Concatenation:
+                {
+                    std::vector<Symbol> rhs;
+                    for (auto const & child : node.Children)
+                        rhs.push_back(Build(child));
+                    Symbol lhs(NewNonterminal());
+                    AddProduction(lhs, std::move(rhs));
+                    return lhs;
+                }
+                case Node::Alternation:
+                {
+                    std::vector<Symbol> alternatives;
+                    for (auto const & child : node.Children)
+                        alternatives.push_back(Build(child));
+                    Symbol lhs(NewNonterminal());
+                    for (auto alternative : alternatives)
+                        AddProduction(lhs, { alternative });
+                    return lhs;
+                }
+                case Node::Repetition:
+                {
+                    if (node.Min > MaxRepeatExpansion || (node.Max != SIZE_MAX && node.Max > MaxRepeatExpansion))
+                    {
+                        errors_->push_back("Repetition count too large");
+                        return NewNonterminal();
+                    }
+                    Symbol elem(Build(node.Children.front()));
+                    std::vector<Symbol> rhs(node.Min, elem);
+                    if (node.Max == SIZE_MAX)
+                    {
+                        // Left recursion keeps the Earley sets small: star = <empty> / star elem
+                        Symbol star(NewNonterminal());
+                        AddProduction(star, {});
+                        AddProduction(star, { star, elem });
+                        rhs.push_back(star);
+                    }
+                    else if (node.Max > node.Min)
+                    {
+                        // upTo(k) = <empty> / elem upTo(k - 1)
+                        Symbol upTo(NewNonterminal());
+                        AddProduction(upTo, {});
+                        AddProduction(upTo, { elem });
+                        for (size_t count = node.Min + 1; count < node.Max; ++count)
+                        {
+                            Symbol next(NewNonterminal());
+                            AddProduction(next, {});
+                            AddProduction(next, { elem, upTo });
+                            upTo = next;
+                        }
+                        rhs.push_back(upTo);
+                    }
+                    Symbol lhs(NewNonterminal());
+                    AddProduction(lhs, std::move(rhs));
+                    return lhs;
+                }
+                case Node::RuleRef:
+                {
+                    auto ruleEntryPtr(rules_.find(node.Text));
+                    if (ruleEntryPtr == rules_.end())
+                    {
+                        errors_->push_back("Undefined rule " + node.Text);
+                        return NewNonterminal();
+                    }
+                    return ruleEntryPtr->second;
+                }
+                }
+                return NewNonterminal();
+            }
+
+            void ComputeNullable()
+            {
+                nullable_.assign(byLhs_.size(), false);
+                bool changed(true);
+                while (changed)
+                {
+                    changed = false;
+                    for (auto const & production : productions_)
+                    {
+                        if (!nullable_[production.Lhs] &&
+                            std::all_of(production.Rhs.begin(), production.Rhs.end(), [&](Symbol symbol) { return symbol >= 0 && nullable_[symbol]; }))
+                        {
+                            nullable_[production.Lhs] = true;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            inline Symbol Next(Item const & item) const
+            {
+                auto const & rhs(productions_[item.Production].Rhs);
+                return item.Dot < rhs.size() ? rhs[item.Dot] : INT32_MAX;
+            }
+
+            // The items are keyed by their dotted rule and origin, Load() checks that the dotted rules fit in 32 bits
+            inline void Add(ItemSet & set, ItemTable & table, Item const & item) const
+            {
+                if (table.Insert(((firstDottedRule_[item.Production] + item.Dot) << 32) | item.Origin))
+                    set.Items.push_back(item);
+            }
+
+            template <typename CHAR_TYPE>
+            static inline uint32_t Code(CHAR_TYPE ch)
+            {
+                return (uint32_t)(typename std::make_unsigned<CHAR_TYPE>::type)ch;
+            }
+
+        public:
+            static size_t const NoMatch = SIZE_MAX;
+
+            bool Load(std::map<std::string, Node> const & nodes, std::vector<std::string> & errors)
+            {
+                *this = EarleyGrammar();
+                nodes_ = &nodes;
+                errors_ = &errors;
+                size_t errorsCount(errors.size());
+                for (auto const & rule : nodes)
+                {
+                    rules_[rule.first] = NewNonterminal();
+                }
+                for (auto const & rule : nodes)
+                {
+                    AddProduction(rules_[rule.first], { Build(rule.second) });
+                }
+                if (dottedRules_ > UINT32_MAX)
+                {
+                    errors.push_back("Grammar too large for the Earley recognizer");
+                }
+                ComputeNullable();
+                nodes_ = nullptr;
+                errors_ = nullptr;
+                return errors.size() == errorsCount;
+            }
+
+            Symbol Rule(std::string const & ruleName) const
+            {
+                auto ruleEntryPtr(rules_.find(ruleName));
+                return ruleEntryPtr != rules_.end() ? ruleEntryPtr->second : -1;
+            }
+
+            // Length of the longest prefix of the input derived from the rule, NoMatch if none
+            template <typename CHAR_TYPE>
+            size_t Match(Symbol rule, CHAR_TYPE const * first, CHAR_TYPE const * last) const
+            {
+                if (rule < 0 || (size_t)rule >= byLhs_.size())
+                    return NoMatch;
+
+                size_t length((size_t)(last - first));
+                size_t longest(NoMatch);
+                std::vector<ItemSet> sets(1);
+                ItemTable tables[2];
+                // Each nonterminal is predicted once per position
+                std::vector<size_t> predicted(byLhs_.size(), SIZE_MAX);
+
+                for (auto production : byLhs_[rule])
+                {
+                    sets[0].Items.push_back({ production, 0, 0 });
+                }
+                predicted[rule] = 0;
+
+                for (size_t pos = 0; pos < sets.size(); ++pos)
+                {
+                    ItemTable & table(tables[pos % 2]);
+                    ItemTable & nextTable(tables[(pos + 1) % 2]);
+
+                    // sets[pos] grows while being processed, items are taken by index
+                    for (size_t index = 0; index < sets[pos].Items.size(); ++index)
+                    {
+                        Item item(sets[pos].Items[index]);
+                        Symbol next(Next(item));
+                        if (next == INT32_MAX)
+                        {
+                            // Completion, empty ones are done by the prediction of nullable nonterminals
+                            Symbol lhs(productions_[item.Production].Lhs);
+                            if (lhs == rule && item.Origin == 0)
+                                longest = pos;
+                            if (item.Origin < pos)
+                            {
+                                auto const & waiting(sets[item.Origin].Waiting);
+                                auto waitingPtr(std::lower_bound(waiting.begin(), waiting.end(), std::make_pair(lhs, (uint32_t)0)));
+                                for (; waitingPtr != waiting.end() && waitingPtr->first == lhs; ++waitingPtr)
+                                {
+                                    Item const & parent(sets[item.Origin].Items[waitingPtr->second]);
+                                    Add(sets[pos], table, { parent.Production, parent.Dot + 1, parent.Origin });
+                                }
+                            }
+                        }
+                        else if (next >= 0)
+                        {
+                            // Prediction
+                            if (predicted[next] != pos)
+                            {
+                                predicted[next] = pos;
+                                for (auto production : byLhs_[next])
+                                {
+                                    sets[pos].Items.push_back({ production, 0, (uint32_t)pos });
+                                }
+                            }
+                            if (nullable_[next])
+                            {
+                                Add(sets[pos], table, { item.Production, item.Dot + 1, item.Origin });
+                            }
+                        }
+                        else if (pos < length)
+                        {
+                            // Scan
+                            auto ch(Code(first[pos]));
+                            if (ch <= 0xFF && sets_[~next][ch])
+                            {
+                                if (sets.size() == pos + 1)
+                                    sets.emplace_back();
+                                Add(sets[pos + 1], nextTable, { item.Production, item.Dot + 1, item.Origin });
+                            }
+                        }
+                    }
+
+                    // Index the items of the position by the nonterminal they wait for, for the later completions
+                    auto & set(sets[pos]);
+                    for (size_t index = 0; index < set.Items.size(); ++index)
+                    {
+                        Symbol next(Next(set.Items[index]));
+                        if (next >= 0 && next != INT32_MAX)
+                            set.Waiting.emplace_back(next, (uint32_t)index);
+                    }
+                    std::sort(set.Waiting.begin(), set.Waiting.end());
+                    table.Clear();
+                }
+                return longest;
+            }
+        };
+    }
+}
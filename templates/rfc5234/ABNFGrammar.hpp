@@ -0,0 +1,323 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// ABNF grammars loaded at runtime, shared by the bytecode machine and the Earley recognizer
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <string>
+#include <bitset>
+
+#include "ParserIO.hpp"
+#include "RFC5324Rules.hpp"
+
+namespace ABNFMachine
+{
+    namespace Impl
+    {
+        using CharSet = std::bitset<256>;
+
+        // Grammar tree, converted from the RuleListData of the ABNF parser
+        class Node
+        {
+        public:
+            enum Kinds
+            {
+                Alternation,
+                Concatenation,
+                Repetition,
+                RuleRef,
+                Chars,
+                String
+            };
+
+            Kinds Kind = Concatenation;
+            std::vector<Node> Children;
+            size_t Min = 1;
+            size_t Max = 1;
+            std::string Text;               // rule name (lower case) or literal
+            bool CaseInsensitive = false;
+            CharSet Set;
+        };
+
+        inline std::string LowerCase(std::string str)
+        {
+            std::transform(str.begin(), str.end(), str.begin(), [](char ch) { return (char)std::tolower((unsigned char)ch); });
+            return str;
+        }
+
+        // Union of the characters matched by the node, false if it doesn't match exactly one character
+        inline bool ToCharSet(Node const & node, std::map<std::string, Node> const & nodes, CharSet & set, size_t depth = 0)
+        {
+            enum { MaxDepth = 64 };
+            if (depth > MaxDepth)
+                return false;
+            switch (node.Kind)
+            {
+            case Node::Chars:
+                set |= node.Set;
+                return true;
+            case Node::Alternation:
+                return std::all_of(node.Children.begin(), node.Children.end(), [&](Node const & child) { return ToCharSet(child, nodes, set, depth + 1); });
+            case Node::Concatenation:
+                return node.Children.size() == 1 && ToCharSet(node.Children.front(), nodes, set, depth + 1);
+            case Node::Repetition:
+                return node.Min == 1 && node.Max == 1 && ToCharSet(node.Children.front(), nodes, set, depth + 1);
+            case Node::RuleRef:
+            {
+                auto ruleEntryPtr(nodes.find(node.Text));
+                return ruleEntryPtr != nodes.end() && ToCharSet(ruleEntryPtr->second, nodes, set, depth + 1);
+            }
+            default:
+                return false;
+            }
+        }
+
+        class Converter
+        {
+            ParserVector<char> const & buffer_;
+            std::vector<std::string> & errors_;
+
+            bool ParseNumber(SubstringPos pos, int base, size_t & value)
+            {
+                auto text(ToString(buffer_, pos));
+                value = std::strtoul(text.c_str(), nullptr, base);
+                if (value > 0xFF)
+                {
+                    errors_.push_back("Value " + text + " out of the byte range");
+                    return false;
+                }
+                return true;
+            }
+
+            Node ConvertNumValSpec(RFC5234ABNF::NumValSpecData const & numValSpec, int base)
+            {
+                using namespace RFC5234ABNF;
+                Node node;
+                size_t first(0);
+                if (!ParseNumber(std::get<NumValSpecFields_FirstValue>(numValSpec), base, first))
+                    return node;
+
+                auto const & seqValues(std::get<NumValSpecFields_SequenceValues>(numValSpec));
+                auto const & rangeLastValue(std::get<NumValSpecFields_RangeLastValue>(numValSpec));
+                if (!IsNull(seqValues))
+                {
+                    node.Kind = Node::String;
+                    node.Text.push_back((char)first);
+                    for (auto const & seqValue : seqValues)
+                    {
+                        // Skip the "." separator
+                        size_t value(0);
+                        if (!ParseNumber(SubstringPos(seqValue.first + 1, seqValue.second), base, value))
+                            return node;
+                        node.Text.push_back((char)value);
+                    }
+                }
+                else
+                {
+                    size_t last(first);
+                    // Skip the "-" separator
+                    if (!IsNull(rangeLastValue) && !ParseNumber(SubstringPos(rangeLastValue.first + 1, rangeLastValue.second), base, last))
+                        return node;
+                    node.Kind = Node::Chars;
+                    for (size_t ch = first; ch <= last; ++ch)
+                        node.Set.set(ch);
+                }
+                return node;
+            }
+
+            Node ConvertElement(RFC5234ABNF::ElementData const & element)
+            {
+                using namespace RFC5234ABNF;
+                Node node;
+                auto const & charVal(std::get<ElementFields_CharVal>(element));
+                auto const & numVal(std::get<ElementFields_NumVal>(element));
+                auto const & group(std::get<ElementFields_Group>(element));
+                auto const & option(std::get<ElementFields_Option>(element));
+                if (!IsNull(charVal))
+                {
+                    // Skip the quotes, quoted strings are case-insensitive (RFC 5234 2.3)
+                    node.Text = ToString(buffer_, SubstringPos(charVal.first + 1, charVal.second - 1));
+                    node.CaseInsensitive = std::any_of(node.Text.begin(), node.Text.end(), [](char ch) { return std::isalpha((unsigned char)ch) != 0; });
+                    if (node.Text.size() == 1)
+                    {
+                        node.Kind = Node::Chars;
+                        node.Set.set((unsigned char)node.Text[0]);
+                        if (node.CaseInsensitive)
+                            node.Set.set((unsigned char)node.Text[0] ^ 0x20);
+                    }
+                    else if (!node.Text.empty())
+                    {
+                        node.Kind = Node::String;
+                        if (node.CaseInsensitive)
+                            node.Text = LowerCase(node.Text);
+                    }
+                }
+                else if (!IsNull(std::get<ElementFields_ProseVal>(element)))
+                {
+                    errors_.push_back("Prose value " + ToString(buffer_, std::get<ElementFields_ProseVal>(element)) + " can't be run");
+                }
+                else if (!IsNull(numVal))
+                {
+                    if (!IsNull(std::get<NumValFields_Hex>(numVal)))
+                        node = ConvertNumValSpec(std::get<NumValFields_Hex>(numVal), 16);
+                    else if (!IsNull(std::get<NumValFields_Bin>(numVal)))
+                        node = ConvertNumValSpec(std::get<NumValFields_Bin>(numVal), 2);
+                    else
+                        node = ConvertNumValSpec(std::get<NumValFields_Dec>(numVal), 10);
+                }
+                else if (!IsNull(group))
+                {
+                    node = ConvertAlternation(group);
+                }
+                else if (!IsNull(option))
+                {
+                    node.Kind = Node::Repetition;
+                    node.Min = 0;
+                    node.Children.push_back(ConvertAlternation(option));
+                }
+                else
+                {
+                    node.Kind = Node::RuleRef;
+                    node.Text = LowerCase(ToString(buffer_, std::get<ElementFields_Rulename>(element)));
+                }
+                return node;
+            }
+
+            Node ConvertRepetition(RFC5234ABNF::RepetitionData const & repetition)
+            {
+                using namespace RFC5234ABNF;
+                auto const & repeat(std::get<RepetitionFields_Repeat>(repetition));
+                if (IsNull(repeat))
+                    return ConvertElement(std::get<RepetitionFields_Element>(repetition));
+
+                Node node;
+                node.Kind = Node::Repetition;
+                node.Min = 0;
+                node.Max = SIZE_MAX;
+                auto const & fixed(std::get<RepeatFields_Fixed>(repeat));
+                auto const & range(std::get<RepeatFields_Range>(repeat));
+                if (!IsEmpty(fixed))
+                {
+                    node.Min = node.Max = std::stoul(ToString(buffer_, fixed));
+                }
+                else
+                {
+                    if (!IsEmpty(std::get<0>(range)))
+                        node.Min = std::stoul(ToString(buffer_, std::get<0>(range)));
+                    if (!IsEmpty(std::get<1>(range)))
+                        node.Max = std::stoul(ToString(buffer_, std::get<1>(range)));
+                }
+                node.Children.push_back(ConvertElement(std::get<RepetitionFields_Element>(repetition)));
+                return node;
+            }
+
+            Node ConvertConcatenation(RFC5234ABNF::ConcatenationData const & concatenation)
+            {
+                if (concatenation.size() == 1)
+                    return ConvertRepetition(concatenation.front());
+
+                Node node;
+                node.Kind = Node::Concatenation;
+                for (auto const & repetition : concatenation)
+                    node.Children.push_back(ConvertRepetition(repetition));
+                return node;
+            }
+
+        public:
+            Converter(ParserVector<char> const & buffer, std::vector<std::string> & errors)
+                : buffer_(buffer)
+                , errors_(errors)
+            {
+            }
+
+            Node ConvertAlternation(RFC5234ABNF::AlternationData const & alternation)
+            {
+                if (alternation.size() == 1)
+                    return ConvertConcatenation(alternation.front());
+
+                Node node;
+                node.Kind = Node::Alternation;
+                for (auto const & concatenation : alternation)
+                    node.Children.push_back(ConvertConcatenation(concatenation));
+                return node;
+            }
+
+            // Add the rules to the map, incremental alternatives (=/) are appended to the existing rule
+            void AddRules(RFC5234ABNF::RuleListData const & rules, std::map<std::string, Node> & mapRules)
+            {
+                using namespace RFC5234ABNF;
+                for (auto const & rule : rules)
+                {
+                    std::string ruleName(LowerCase(ToString(buffer_, std::get<RuleFields_Rulename>(rule))));
+                    Node alternatives(ConvertAlternation(std::get<RuleFields_Elements>(rule)));
+
+                    auto ruleEntryPtr(mapRules.find(ruleName));
+                    if (ToString(buffer_, std::get<RuleFields_DefinedAs>(rule)).find("=/") != std::string::npos && ruleEntryPtr != mapRules.end())
+                    {
+                        Node & existing(ruleEntryPtr->second);
+                        if (existing.Kind != Node::Alternation)
+                        {
+                            Node single(std::move(existing));
+                            existing = Node();
+                            existing.Kind = Node::Alternation;
+                            existing.Children.push_back(std::move(single));
+                        }
+                        if (alternatives.Kind == Node::Alternation)
+                            std::move(alternatives.Children.begin(), alternatives.Children.end(), std::back_inserter(existing.Children));
+                        else
+                            existing.Children.push_back(std::move(alternatives));
+                    }
+                    else
+                    {
+                        mapRules[ruleName] = std::move(alternatives);
+                    }
+                }
+            }
+        };
+
+        // Core rules as defined in the Appendix B https://tools.ietf.org/html/rfc5234#appendix-B
+        inline std::map<std::string, Node> const & CoreRules()
+        {
+            static std::map<std::string, Node> const coreRules([]
+            {
+                std::string str(
+                    "ALPHA = %x41-5A / %x61-7A\r\n"
+                    "BIT = \"0\" / \"1\"\r\n"
+                    "CHAR = %x01-7F\r\n"
+                    "CR = %x0D\r\n"
+#ifdef PARSER_LF_AS_CRLF
+                    "CRLF = LF / CR LF\r\n"
+#else
+                    "CRLF = CR LF\r\n"
+#endif
+                    "CTL = %x00-1F / %x7F\r\n"
+                    "DIGIT = %x30-39\r\n"
+                    "DQUOTE = %x22\r\n"
+                    "HEXDIG = DIGIT / \"A\" / \"B\" / \"C\" / \"D\" / \"E\" / \"F\"\r\n"
+                    "HTAB = %x09\r\n"
+                    "LF = %x0A\r\n"
+                    "LWSP = *(WSP / CRLF WSP)\r\n"
+                    "OCTET = %x00-FF\r\n"
+                    "SP = %x20\r\n"
+                    "VCHAR = %x21-7E\r\n"
+                    "WSP = SP / HTAB\r\n");
+
+                std::map<std::string, Node> mapRules;
+                auto parser(Make_ParserFromString(str));
+                RFC5234ABNF::RuleListData rules;
+                if (RFC5234ABNF::ParseExact(parser, &rules))
+                {
+                    std::vector<std::string> errors;
+                    Converter(parser.OutputBuffer(), errors).AddRules(rules, mapRules);
+                }
+                return mapRules;
+            }());
+            return coreRules;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// ABNF rules of a text being edited, parsed again rule by rule
+#pragma once
+
+#include "ParserIncremental.hpp"
+#include "RFC5324Rules.hpp"
+
+namespace RFC5234ABNF
+{
+    // An element of the rulelist: a rule, or an empty line giving no data
+    PARSER_RULE(rulelist_elem, Alternatives(rule(), Idx<INDEX_NONE>(), Sequence(Repeat(c_wsp()), c_nl())));
+
+    using IncrementalRuleList = IncrementalParser<RuleListData, rulelist_elem>;
+}
@@ -0,0 +1,544 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// ABNF bytecode machine: runs ABNF grammars loaded at runtime
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <bitset>
+#include <cstdint>
+#include <type_traits>
+
+#include "ABNFGrammar.hpp"
+#include "ABNFEarley.hpp"
+
+// The GNU compilers support labels as values, the dispatch jumps directly from an instruction to the next one.
+// Other compilers run the same instructions from a switch.
+#if defined(__GNUC__) && !defined(ABNF_MACHINE_SWITCH_DISPATCH)
+#define ABNF_MACHINE_THREADED_DISPATCH
+#endif
+
+namespace ABNFMachine
+{
+    enum class OpCode : uint8_t
+    {
+        Char,           // match the character Arg
+        Set,            // match a character from the class table Arg
+        Literal,        // match the literal Arg
+        ILiteral,       // match the literal Arg, ignoring the case of letters
+        Call,           // call the rule at Arg
+        Return,
+        Jump,           // continue at Arg
+        Choice,         // on failure, backtrack to the current position and continue at Arg
+        Commit,         // drop the last choice and continue at Arg
+        LoopCommit,     // update the last choice to the current position and continue at Arg, leave the loop if nothing was consumed
+        LongestBegin,   // start of alternatives where the longest match wins
+        LongestAlt,     // on failure of the current alternative, continue at Arg
+        LongestRecord,  // record the end of the current alternative, rewind to the start of the alternatives
+        LongestEnd,     // continue after the longest alternative, fail if none matched
+        Fail,
+        End
+    };
+
+    // Engine running a rule: the bytecode is fast but backtracks, its worst case is exponential on ambiguous
+    // grammars (ie. nested CFWS). The Earley recognizer is slower but bounded in O(n^3), and matches the exact
+    // language of the rule where the bytecode doesn't backtrack into repetitions nor alternatives.
+    enum class Engine
+    {
+        Bytecode,
+        Earley
+    };
+
+    class Instruction
+    {
+    public:
+        OpCode Op;
+        uint32_t Arg;
+    };
+
+    // A grammar compiled into bytecode
+    class Program
+    {
+        enum { MaxRepeatExpansion = 255, MaxStackDepth = 1 << 16 };
+
+        std::vector<Instruction> code_;
+        std::vector<Impl::CharSet> sets_;
+        std::vector<std::string> literals_;
+        std::map<std::string, uint32_t> rules_;    // rule name (lower case) to entry point
+        std::vector<std::string> errors_;
+        Impl::EarleyGrammar earley_;
+        std::map<size_t, Impl::EarleyGrammar::Symbol> earleyRules_;   // entry points of the rules run by earley_
+
+        // Intermediate state of the compilation
+        std::map<std::string, Impl::Node> const * nodes_ = nullptr;
+        std::map<std::string, uint32_t> ruleBodies_;
+        std::vector<std::pair<uint32_t, std::string> > calls_;
+
+        uint32_t Emit(OpCode op, uint32_t arg = 0)
+        {
+            code_.push_back({ op, arg });
+            return (uint32_t)code_.size() - 1;
+        }
+
+        uint32_t Here() const
+        {
+            return (uint32_t)code_.size();
+        }
+
+        void EmitCharSet(Impl::CharSet const & set)
+        {
+            if (set.count() == 1)
+            {
+                for (size_t ch = 0; ch < set.size(); ++ch)
+                {
+                    if (set[ch])
+                        Emit(OpCode::Char, (uint32_t)ch);
+                }
+            }
+            else
+            {
+                auto setPtr(std::find(sets_.begin(), sets_.end(), set));
+                Emit(OpCode::Set, (uint32_t)(setPtr - sets_.begin()));
+                if (setPtr == sets_.end())
+                    sets_.push_back(set);
+            }
+        }
+
+        void Compile(Impl::Node const & node)
+        {
+            using Impl::Node;
+
+            // Character classes, including rules like ALPHA, are matched by a single table lookup
+            Impl::CharSet set;
+            if (node.Kind != Node::Chars && Impl::ToCharSet(node, *nodes_, set))
+            {
+                EmitCharSet(set);
+                return;
+            }
+
+            switch (node.Kind)
+            {
+            case Node::Chars:
+                EmitCharSet(node.Set);
+                break;
+            case Node::String:
+                Emit(node.CaseInsensitive ? OpCode::ILiteral : OpCode::Literal, (uint32_t)literals_.size());
+                literals_.push_back(node.Text);
+                break;
+            case Node::Concatenation:
+                for (auto const & child : node.Children)
+                    Compile(child);
+                break;
+            case Node::Alternation:
+            {
+                // Same semantic as Alternatives: the longest alternative wins
+                Emit(OpCode::LongestBegin);
+                for (auto const & child : node.Children)
+                {
+                    auto alt(Emit(OpCode::LongestAlt));
+                    Compile(child);
+                    Emit(OpCode::LongestRecord);
+                    code_[alt].Arg = Here();
+                }
+                Emit(OpCode::LongestEnd);
+                break;
+            }
+            case Node::Repetition:
+            {
+                if (node.Min > MaxRepeatExpansion || (node.Max != SIZE_MAX && node.Max > MaxRepeatExpansion))
+                {
+                    errors_.push_back("Repetition count too large");
+                    break;
+                }
+                for (size_t count = 0; count < node.Min; ++count)
+                    Compile(node.Children.front());
+                if (node.Max == SIZE_MAX)
+                {
+                    // Greedy loop, without backtracking into it like Repeat
+                    auto choice(Emit(OpCode::Choice));
+                    auto loop(Here());
+                    Compile(node.Children.front());
+                    Emit(OpCode::LoopCommit, loop);
+                    code_[choice].Arg = Here();
+                }
+                else if (node.Max > node.Min)
+                {
+                    std::vector<uint32_t> choices;
+                    for (size_t count = node.Min; count < node.Max; ++count)
+                    {
+                        choices.push_back(Emit(OpCode::Choice));
+                        Compile(node.Children.front());
+                        Emit(OpCode::Commit, Here() + 1);
+                    }
+                    for (auto choice : choices)
+                        code_[choice].Arg = Here();
+                }
+                break;
+            }
+            case Node::RuleRef:
+                if (nodes_->find(node.Text) == nodes_->end())
+                {
+                    errors_.push_back("Undefined rule " + node.Text);
+                    break;
+                }
+                calls_.emplace_back(Emit(OpCode::Call), node.Text);
+                break;
+            }
+        }
+
+        template <typename CHAR_TYPE>
+        static inline uint32_t Code(CHAR_TYPE ch)
+        {
+            return (uint32_t)(typename std::make_unsigned<CHAR_TYPE>::type)ch;
+        }
+
+    public:
+        static size_t const NoMatch = SIZE_MAX;
+
+        // Compile the rules parsed by RFC5234ABNF::rulelist, the core rules are added unless redefined
+        bool Load(RFC5234ABNF::RuleListData const & rules, ParserVector<char> const & buffer)
+        {
+            *this = Program();
+
+            std::map<std::string, Impl::Node> nodes(Impl::CoreRules());
+            Impl::Converter(buffer, errors_).AddRules(rules, nodes);
+
+            nodes_ = &nodes;
+            for (auto const & rule : nodes)
+            {
+                // Entry point: call the rule and stop
+                rules_[rule.first] = Here();
+                calls_.emplace_back(Emit(OpCode::Call), rule.first);
+                Emit(OpCode::End);
+            }
+            for (auto const & rule : nodes)
+            {
+                ruleBodies_[rule.first] = Here();
+                Compile(rule.second);
+                Emit(OpCode::Return);
+            }
+            for (auto const & call : calls_)
+            {
+                code_[call.first].Arg = ruleBodies_[call.second];
+            }
+            nodes_ = nullptr;
+            ruleBodies_.clear();
+            calls_.clear();
+
+            // Most errors are the same as the bytecode ones, only the others are added
+            std::vector<std::string> earleyErrors;
+            earley_.Load(nodes, earleyErrors);
+            for (auto const & error : earleyErrors)
+            {
+                if (std::find(errors_.begin(), errors_.end(), error) == errors_.end())
+                    errors_.push_back(error);
+            }
+
+            if (!errors_.empty())
+            {
+                code_.clear();
+                rules_.clear();
+                return false;
+            }
+            return true;
+        }
+
+        // Parse and compile ABNF rules
+        bool Load(std::string const & abnf)
+        {
+            auto parser(Make_ParserFromString(abnf));
+            RFC5234ABNF::RuleListData rules;
+            if (RFC5234ABNF::ParseExact(parser, &rules))
+            {
+                return Load(rules, parser.OutputBuffer());
+            }
+
+            *this = Program();
+            std::stringstream ss;
+            for (auto const & parseError : parser.Errors())
+            {
+                parseError(ss, "");
+            }
+            errors_.push_back(ss.str());
+            return false;
+        }
+
+        std::vector<std::string> const & Errors() const
+        {
+            return errors_;
+        }
+
+        size_t CodeSize() const
+        {
+            return code_.size();
+        }
+
+        // Entry point of a rule, to be given to Match
+        size_t Rule(std::string const & ruleName) const
+        {
+            auto ruleEntryPtr(rules_.find(Impl::LowerCase(ruleName)));
+            return ruleEntryPtr != rules_.end() ? ruleEntryPtr->second : NoMatch;
+        }
+
+        // Select the engine running a rule (bytecode by default), returns false for an unknown rule
+        bool SetEngine(std::string const & ruleName, Engine engine)
+        {
+            size_t rule(Rule(ruleName));
+            if (rule == NoMatch)
+                return false;
+            if (engine == Engine::Earley)
+                earleyRules_[rule] = earley_.Rule(Impl::LowerCase(ruleName));
+            else
+                earleyRules_.erase(rule);
+            return true;
+        }
+
+        // Length of the longest prefix of the input matched by the rule, NoMatch on failure
+        template <typename CHAR_TYPE>
+        size_t Match(size_t rule, CHAR_TYPE const * first, CHAR_TYPE const * last) const
+        {
+            if (!earleyRules_.empty())
+            {
+                auto earleyRulePtr(earleyRules_.find(rule));
+                if (earleyRulePtr != earleyRules_.end())
+                    return earley_.Match(earleyRulePtr->second, first, last);
+            }
+            return Run(rule, first, last);
+        }
+
+    private:
+        template <typename CHAR_TYPE>
+        size_t Run(size_t rule, CHAR_TYPE const * first, CHAR_TYPE const * last) const
+        {
+            if (rule >= code_.size())
+                return NoMatch;
+
+            enum FrameKind { FrameCall, FrameChoice, FrameLongest };
+            class Frame
+            {
+            public:
+                FrameKind Kind;
+                Instruction const * Next;
+                CHAR_TYPE const * Pos;
+                CHAR_TYPE const * Best;
+            };
+
+            std::vector<Frame> stack;
+            stack.reserve(64);
+
+            Instruction const * const code(code_.data());
+            Instruction const * ip(code + rule);
+            CHAR_TYPE const * pos(first);
+
+#ifdef ABNF_MACHINE_THREADED_DISPATCH
+            // Same order as OpCode
+            static void * const dispatch[] =
+            {
+                &&op_Char, &&op_Set, &&op_Literal, &&op_ILiteral, &&op_Call, &&op_Return, &&op_Jump, &&op_Choice, &&op_Commit,
+                &&op_LoopCommit, &&op_LongestBegin, &&op_LongestAlt, &&op_LongestRecord, &&op_LongestEnd, &&op_Fail, &&op_End
+            };
+#define ABNF_MACHINE_OP(name) op_##name:
+#define ABNF_MACHINE_NEXT() goto *dispatch[(size_t)ip->Op]
+            ABNF_MACHINE_NEXT();
+#else
+#define ABNF_MACHINE_OP(name) case OpCode::name:
+#define ABNF_MACHINE_NEXT() goto next
+        next:
+            switch (ip->Op)
+            {
+#endif
+            ABNF_MACHINE_OP(Char)
+                if (pos == last || Code(*pos) != ip->Arg)
+                    goto fail;
+                ++pos;
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(Set)
+            {
+                uint32_t ch;
+                if (pos == last || (ch = Code(*pos)) > 0xFF || !sets_[ip->Arg][ch])
+                    goto fail;
+                ++pos;
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            }
+            ABNF_MACHINE_OP(Literal)
+            {
+                auto const & literal(literals_[ip->Arg]);
+                if ((size_t)(last - pos) < literal.size() ||
+                    !std::equal(literal.begin(), literal.end(), pos, [](char expected, CHAR_TYPE ch) { return Code(ch) == (unsigned char)expected; }))
+                    goto fail;
+                pos += literal.size();
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            }
+            ABNF_MACHINE_OP(ILiteral)
+            {
+                // Letters of the literal are stored lower case
+                auto const & literal(literals_[ip->Arg]);
+                if ((size_t)(last - pos) < literal.size() ||
+                    !std::equal(literal.begin(), literal.end(), pos, [](char expected, CHAR_TYPE ch)
+                    {
+                        auto code(Code(ch));
+                        return (code >= 'A' && code <= 'Z' ? code | 0x20 : code) == (unsigned char)expected;
+                    }))
+                    goto fail;
+                pos += literal.size();
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            }
+            ABNF_MACHINE_OP(Call)
+                if (stack.size() >= MaxStackDepth)
+                    return NoMatch;
+                stack.push_back({ FrameCall, ip + 1, nullptr, nullptr });
+                ip = code + ip->Arg;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(Return)
+                ip = stack.back().Next;
+                stack.pop_back();
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(Jump)
+                ip = code + ip->Arg;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(Choice)
+                if (stack.size() >= MaxStackDepth)
+                    return NoMatch;
+                stack.push_back({ FrameChoice, code + ip->Arg, pos, nullptr });
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(Commit)
+                stack.pop_back();
+                ip = code + ip->Arg;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(LoopCommit)
+                if (stack.back().Pos == pos)
+                {
+                    stack.pop_back();
+                    ++ip;
+                }
+                else
+                {
+                    stack.back().Pos = pos;
+                    ip = code + ip->Arg;
+                }
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(LongestBegin)
+                if (stack.size() >= MaxStackDepth)
+                    return NoMatch;
+                stack.push_back({ FrameLongest, nullptr, pos, nullptr });
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(LongestAlt)
+                stack.back().Next = code + ip->Arg;
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            ABNF_MACHINE_OP(LongestRecord)
+            {
+                Frame & frame(stack.back());
+                if (frame.Best == nullptr || pos > frame.Best)
+                    frame.Best = pos;
+                pos = frame.Pos;
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            }
+            ABNF_MACHINE_OP(LongestEnd)
+            {
+                auto best(stack.back().Best);
+                stack.pop_back();
+                if (best == nullptr)
+                    goto fail;
+                pos = best;
+                ++ip;
+                ABNF_MACHINE_NEXT();
+            }
+            ABNF_MACHINE_OP(Fail)
+                goto fail;
+            ABNF_MACHINE_OP(End)
+                return (size_t)(pos - first);
+#ifndef ABNF_MACHINE_THREADED_DISPATCH
+            }
+#endif
+
+        fail:
+            // Backtrack to the last choice or to the next alternative, dropping the rules called since then
+            while (!stack.empty())
+            {
+                Frame & frame(stack.back());
+                if (frame.Kind == FrameLongest)
+                {
+                    pos = frame.Pos;
+                    ip = frame.Next;
+                    ABNF_MACHINE_NEXT();
+                }
+                if (frame.Kind == FrameChoice)
+                {
+                    pos = frame.Pos;
+                    ip = frame.Next;
+                    stack.pop_back();
+                    ABNF_MACHINE_NEXT();
+                }
+                stack.pop_back();
+            }
+            return NoMatch;
+#undef ABNF_MACHINE_OP
+#undef ABNF_MACHINE_NEXT
+        }
+
+    public:
+        template <typename CHAR_TYPE>
+        size_t Match(std::string const & ruleName, std::basic_string<CHAR_TYPE> const & str) const
+        {
+            return Match(Rule(ruleName), str.data(), str.data() + str.size());
+        }
+
+        // The rule must match the whole input
+        template <typename CHAR_TYPE>
+        bool MatchExact(size_t rule, CHAR_TYPE const * first, CHAR_TYPE const * last) const
+        {
+            return Match(rule, first, last) == (size_t)(last - first);
+        }
+
+        template <typename CHAR_TYPE>
+        bool MatchExact(std::string const & ruleName, std::basic_string<CHAR_TYPE> const & str) const
+        {
+            return Match(ruleName, str) == str.size();
+        }
+
+        void Disassemble(std::ostream & os) const
+        {
+            static char const * const names[] =
+            {
+                "Char", "Set", "Literal", "ILiteral", "Call", "Return", "Jump", "Choice", "Commit",
+                "LoopCommit", "LongestBegin", "LongestAlt", "LongestRecord", "LongestEnd", "Fail", "End"
+            };
+            std::map<uint32_t, std::string> entries;
+            for (auto const & rule : rules_)
+                entries[rule.second] = rule.first;
+            for (size_t pc = 0; pc < code_.size(); ++pc)
+            {
+                auto entryPtr(entries.find((uint32_t)pc));
+                if (entryPtr != entries.end())
+                    os << entryPtr->second << ":" << std::endl;
+                auto const & instruction(code_[pc]);
+                os << std::setw(6) << std::dec << pc << "  " << names[(size_t)instruction.Op];
+                switch (instruction.Op)
+                {
+                case OpCode::Return: case OpCode::LongestBegin: case OpCode::LongestRecord: case OpCode::LongestEnd: case OpCode::Fail: case OpCode::End:
+                    break;
+                case OpCode::Literal: case OpCode::ILiteral:
+                    os << " \"" << literals_[instruction.Arg] << "\"";
+                    break;
+                default:
+                    os << " " << instruction.Arg;
+                    break;
+                }
+                os << std::endl;
+            }
+        }
+    };
+}
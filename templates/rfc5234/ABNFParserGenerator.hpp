@@ -15,7 +15,7 @@
 
 #include "RFC5324Rules.hpp"
 
-void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rules, std::vector<char> const & buffer)
+void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rules, ParserVector<char> const & buffer)
 {
     using namespace RFC5234ABNF;
 
@@ -48,18 +48,18 @@ void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rul
             std::stringstream ss;
             if (!IsNull(seqValues))
             {
-                ss << "Sequence(";
-                generateChar(firstValue, prefix);
+                ss << "Literal<" << prefix << ToString(buffer, firstValue);
                 for (auto const & seqValue : seqValues)
                 {
-                    ss << ", ";
-                    generateChar(seqValue, prefix);
+                    // Skip the "." separator
+                    ss << ", " << prefix << ToString(buffer, SubstringPos(seqValue.first + 1, seqValue.second));
                 }
-                ss << ")";
+                ss << ">()";
             }
             else if (!IsNull(rangeLastValue))
             {
-                ss << "CharRange<" << prefix << ToString(buffer, firstValue) << ", " << prefix << ToString(buffer, rangeLastValue) << ">()";
+                // Skip the "-" separator
+                ss << "CharRange<" << prefix << ToString(buffer, firstValue) << ", " << prefix << ToString(buffer, SubstringPos(rangeLastValue.first + 1, rangeLastValue.second)) << ">()";
             }
             else
             {
@@ -89,37 +89,53 @@ void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rul
             }
         };
 
-        auto generateElement = [&](ElementData const & element, bool insideRepeat)
+        auto generateElement = [&](ElementData const & element)
         {
             auto charValOrProseVal(std::get<ElementFields_CharVal>(element));
+            // quoted strings are case-insensitive (RFC 5234 2.3), prose values are taken as is
+            bool caseInsensitive(!IsNull(charValOrProseVal));
             if (IsNull(charValOrProseVal))
                 charValOrProseVal = std::get<ElementFields_ProseVal>(element);
             if (!IsNull(charValOrProseVal))
             {
                 // Skip delimiters <> or ""
-                size_t length(std::get<1>(charValOrProseVal) - std::get<0>(charValOrProseVal));
-                if (length > 2)
+                size_t first(std::get<0>(charValOrProseVal) + 1);
+                size_t last(std::get<1>(charValOrProseVal) - 1);
+                if (last > first)
                 {
-                    std::stringstream ss;
-                    if (length > 3 && !insideRepeat)
+                    if (caseInsensitive)
                     {
-                        ss << "Sequence(";
+                        caseInsensitive = std::any_of(buffer.begin() + first, buffer.begin() + last, [](char ch) { return std::isalpha((unsigned char)ch) != 0; });
                     }
 
-                    bool first = true;
-                    for (size_t t = std::get<0>(charValOrProseVal) + 1; t < std::get<1>(charValOrProseVal) - 1; ++t)
+                    auto generateCode = [](std::ostream & os, MaxCharType ch)
                     {
-                        if (!first)
-                            ss << ", ";
-                        first = false;
+                        os << "0x" << std::uppercase << std::hex << std::setfill('0') << std::setw(2) << ch;
+                    };
 
-                        ss << "CharVal<0x" << std::uppercase << std::hex << std::setfill('0') << std::setw(2) << (MaxCharType)buffer[t] << ">()";
+                    std::stringstream ss;
+                    if (last - first == 1)
+                    {
+                        ss << "CharVal<";
+                        generateCode(ss, (MaxCharType)buffer[first]);
+                        if (caseInsensitive)
+                        {
+                            ss << ", ";
+                            generateCode(ss, (MaxCharType)buffer[first] ^ 0x20);
+                        }
                     }
-
-                    if (length > 3 && !insideRepeat)
+                    else
                     {
-                        ss << ")";
+                        // Several characters are matched at once by a literal
+                        ss << (caseInsensitive ? "ILiteral<" : "Literal<");
+                        for (size_t t = first; t < last; ++t)
+                        {
+                            if (t > first)
+                                ss << ", ";
+                            generateCode(ss, (MaxCharType)buffer[t]);
+                        }
                     }
+                    ss << ">()";
                     return ss.str();
                 }
                 else
@@ -180,7 +196,7 @@ void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rul
                     if (!IsEmpty(fixed))
                     {
                         auto num(ToString(buffer, fixed));
-                        ss << num << ", " << num << ">(";
+                        ss << num << ", " << num;
                     }
                     else if (IsEmpty(std::get<0>(range)))
                     {
@@ -192,7 +208,7 @@ void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rul
                     }
                     else
                     {
-                        ss << ToString(buffer, std::get<0>(range)) << ", " << ToString(buffer, std::get<1>(range)) << ">(";
+                        ss << ToString(buffer, std::get<0>(range)) << ", " << ToString(buffer, std::get<1>(range));
                     }
 
                     ss << ">";
@@ -201,7 +217,7 @@ void GenerateABNFParser(std::ostream & os, RFC5234ABNF::RuleListData const & rul
                 ss << "(";
             }
 
-            ss << generateElement(element, insideRepeat);
+            ss << generateElement(element);
 
             if (insideRepeat)
             {
@@ -11,7 +11,7 @@ namespace RFC5234ABNF
     using namespace RFC5234Core;
 
     // rulename       =  ALPHA *(ALPHA / DIGIT / "-")
-    PARSER_RULE(rulename, Sequence(ALPHA(), Repeat(Alternatives(ALPHA(), DIGIT(), CharVal<'-'>()))));
+    PARSER_RULE(rulename, Regular(Sequence(ALPHA(), Repeat(Alternatives(ALPHA(), DIGIT(), CharVal<'-'>())))));
 
     // comment        =  ";" *(WSP / VCHAR) CRLF
     PARSER_RULE(comment, Sequence(CharVal<';'>(), Repeat(Alternatives(WSP(), VCHAR())), CRLF()))
@@ -27,7 +27,7 @@ namespace RFC5234ABNF
     //                ; basic rules definition and
     //                ;  incremental alternatives
     
-    PARSER_RULE(defined_as, Sequence(Repeat(c_wsp()), Alternatives(CharVal<'='>(), Sequence(CharVal<'='>(), CharVal<'/'>())), Repeat(c_wsp())));
+    PARSER_RULE(defined_as, Sequence(Repeat(c_wsp()), Alternatives(CharVal<'='>(), Literal<'=', '/'>()), Repeat(c_wsp())));
 
     using RepeatData = std::tuple<SubstringPos, std::tuple<SubstringPos, SubstringPos> >;
     enum RepeatFields
@@ -44,11 +44,11 @@ namespace RFC5234ABNF
 
     using GroupData = AlternationData;
     // group          =  "(" *c-wsp alternation *c-wsp ")"
-    PARSER_RULE(group, Sequence(CharVal<'('>(), Idx<INDEX_NONE>(), Repeat(c_wsp()), Idx<INDEX_THIS>(), alternation(), Idx<INDEX_NONE>(), Repeat(c_wsp()), CharVal<')'>()));
+    PARSER_RULE(group, Sequence(CharVal<'('>(), Skip(Repeat(c_wsp())), Idx<INDEX_THIS>(), alternation(), Skip(Repeat(c_wsp())), CharVal<')'>()));
 
     using OptionData = AlternationData;
     // option         =  "[" *c-wsp alternation *c-wsp "]"
-    PARSER_RULE(option, Sequence(CharVal<'['>(), Idx<INDEX_NONE>(),Repeat(c_wsp()), Idx<INDEX_THIS>(), alternation(), Idx<INDEX_NONE>(),Repeat(c_wsp()), CharVal<']'>()));
+    PARSER_RULE(option, Sequence(CharVal<'['>(), Skip(Repeat(c_wsp())), Idx<INDEX_THIS>(), alternation(), Skip(Repeat(c_wsp())), CharVal<']'>()));
 
     // prose-val      =  "<" *(%x20-3D / %x3F-7E) ">"
     PARSER_RULE(prose_val, Sequence(CharVal<'<'>(), Repeat(Alternatives(CharRange<0x20, 0x3D>(), CharRange<0x3F, 0x7E>())), CharVal<'>'>()));
@@ -56,7 +56,7 @@ namespace RFC5234ABNF
     // char-val       =  DQUOTE *(%x20-21 / %x23-7E) DQUOTE
     PARSER_RULE(char_val, Sequence(CharVal<'\"'>(), Repeat(Alternatives(CharRange<0x20, 0x21>(), CharRange<0x23, 0x7E>())), CharVal<'\"'>()));
     
-    using NumValSpecData = std::tuple<SubstringPos, std::vector<SubstringPos>, SubstringPos >;
+    using NumValSpecData = std::tuple<SubstringPos, ParserVector<SubstringPos>, SubstringPos >;
     enum NumValSpecFields
     {
         NumValSpecFields_FirstValue,
@@ -64,20 +64,23 @@ namespace RFC5234ABNF
         NumValSpecFields_RangeLastValue
     };
 
+    // The optional part is parsed as *("." 1*BIT) ["-" 1*BIT]: an optional Union failing would reset the whole
+    // NumValSpecData, including the first value. Both values keep their "." or "-" separator.
+
     // bin-val        =  "b" 1*BIT
     //                   [ 1*("." 1*BIT) / ("-" 1*BIT) ]
     PARSER_RULE(bin_val, Sequence(CharVal<'b'>(), Idx<NumValSpecFields_FirstValue>(), Repeat<1>(BIT()),
-        Idx<INDEX_THIS>(), Optional(Union(Idx<NumValSpecFields_SequenceValues>(), Repeat<1>(CharVal<'.'>(), Repeat<1>(BIT())), Idx<INDEX_THIS>(), Sequence(CharVal<'-'>(), Idx<NumValSpecFields_RangeLastValue>(), Repeat<1>(BIT()))))));
+        Idx<NumValSpecFields_SequenceValues>(), Repeat(CharVal<'.'>(), Repeat<1>(BIT())), Idx<NumValSpecFields_RangeLastValue>(), Optional(CharVal<'-'>(), Repeat<1>(BIT()))));
 
     // dec-val        =  "d" 1*DIGIT
     //                   [ 1*("." 1*DIGIT) / ("-" 1*DIGIT) ]
     PARSER_RULE(dec_val, Sequence(CharVal<'d'>(), Idx<NumValSpecFields_FirstValue>(), Repeat<1>(DIGIT()),
-        Idx<INDEX_THIS>(), Optional(Union(Idx<NumValSpecFields_SequenceValues>(), Repeat<1>(CharVal<'.'>(), Repeat<1>(DIGIT())), Idx<INDEX_THIS>(), Sequence(CharVal<'-'>(), Idx<NumValSpecFields_RangeLastValue>(), Repeat<1>(DIGIT()))))));
+        Idx<NumValSpecFields_SequenceValues>(), Repeat(CharVal<'.'>(), Repeat<1>(DIGIT())), Idx<NumValSpecFields_RangeLastValue>(), Optional(CharVal<'-'>(), Repeat<1>(DIGIT()))));
 
     // hex-val        =  "x" 1*HEXDIG
     //                   [ 1*("." 1*HEXDIG) / ("-" 1*HEXDIG) ]
     PARSER_RULE(hex_val, Sequence(CharVal<'x'>(), Idx<NumValSpecFields_FirstValue>(), Repeat<1>(HEXDIG()),
-        Idx<INDEX_THIS>(), Optional(Union(Idx<NumValSpecFields_SequenceValues>(), Repeat<1>(CharVal<'.'>(), Repeat<1>(HEXDIG())), Idx<INDEX_THIS>(), Sequence(CharVal<'-'>(), Idx<NumValSpecFields_RangeLastValue>(), Repeat<1>(HEXDIG()))))));
+        Idx<NumValSpecFields_SequenceValues>(), Repeat(CharVal<'.'>(), Repeat<1>(HEXDIG())), Idx<NumValSpecFields_RangeLastValue>(), Optional(CharVal<'-'>(), Repeat<1>(HEXDIG()))));
 
     using NumValData = std::tuple<NumValSpecData, NumValSpecData, NumValSpecData>;
     enum NumValFields
@@ -114,25 +117,30 @@ namespace RFC5234ABNF
     // repetition     =  [repeat] element
     PARSER_RULE_CDATA(repetition, RepetitionData, Sequence(Optional(repeat()), element()));
 
-    class ConcatenationData : public std::vector<RepetitionData>
+    // With the constructors of the vector: std::pmr gives its allocator to the vectors it contains
+    class ConcatenationData : public ParserVector<RepetitionData>
     {
+    public:
+        using ParserVector<RepetitionData>::vector;
     };
 
     // concatenation  =  repetition *(1*c-wsp repetition)
-    PARSER_RULE_CDATA(concatenation, ConcatenationData, HeadTail(repetition(), Idx<INDEX_NONE>(), Repeat<1>(c_wsp()), Idx<INDEX_THIS>(), repetition()));
+    PARSER_RULE_CDATA(concatenation, ConcatenationData, HeadTail(repetition(), Skip(Repeat<1>(c_wsp())), Idx<INDEX_THIS>(), repetition()));
 
-    class AlternationData : public std::vector<ConcatenationData>
+    class AlternationData : public ParserVector<ConcatenationData>
     {
+    public:
+        using ParserVector<ConcatenationData>::vector;
     };
 
     // alternation    =  concatenation
     //                  *(*c-wsp "/" *c-wsp concatenation)
     PARSER_RULE_PARTIAL(alternation,
-        HeadTail(concatenation(), Idx<INDEX_NONE>(), Repeat(c_wsp()), CharVal<'/'>(), Idx<INDEX_NONE>(), Repeat(c_wsp()), Idx<INDEX_THIS>(), concatenation()));
+        HeadTail(concatenation(), Skip(Repeat(c_wsp())), CharVal<'/'>(), Skip(Repeat(c_wsp())), Idx<INDEX_THIS>(), concatenation()));
 
     using ElementsData = AlternationData;
     // elements       =  alternation *c-wsp
-    PARSER_RULE(elements, Sequence(Idx<INDEX_THIS>(), alternation(), Idx<INDEX_NONE>(), Repeat(c_wsp())));
+    PARSER_RULE(elements, Sequence(Idx<INDEX_THIS>(), alternation(), Skip(Repeat(c_wsp()))));
 
     using RuleData = std::tuple<SubstringPos, SubstringPos, ElementsData>;
     enum RuleFields
@@ -146,7 +154,7 @@ namespace RFC5234ABNF
     //                            ;  with white space
     PARSER_RULE_CDATA(rule, RuleData, Sequence(rulename(), defined_as(), elements(), Idx<INDEX_NONE>(), c_nl()));
 
-    using RuleListData = std::vector<RuleData>;
+    using RuleListData = ParserVector<RuleData>;
     // rulelist       =  1*( rule / (*c-wsp c-nl) )
     PARSER_RULE_CDATA(rulelist, RuleListData, Repeat<1>(Alternatives(rule(), Idx<INDEX_NONE>(), Sequence(Repeat(c_wsp()), c_nl()))));
 }
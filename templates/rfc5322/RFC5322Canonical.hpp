@@ -0,0 +1,187 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// canonical form of the parsed addresses, e.g. for deduplication keys
+#pragma once
+
+#include "RFC5322Data.inl"
+
+namespace Impl
+{
+    // Writes into the buffer of the caller, what doesn't fit is only counted
+    template <typename CHAR_TYPE>
+    class CanonicalWriter
+    {
+        CHAR_TYPE * dest_;
+        size_t capacity_;
+        size_t size_;
+    public:
+        inline CanonicalWriter(CHAR_TYPE * dest, size_t capacity)
+            : dest_(dest), capacity_(capacity), size_(0)
+        {
+        }
+
+        inline void operator()(CHAR_TYPE ch)
+        {
+            if (size_ < capacity_)
+                dest_[size_] = ch;
+            size_++;
+        }
+
+        // ASCII lowercase, without branches so that the compiler vectorizes the loops
+        static inline CHAR_TYPE Lower(CHAR_TYPE ch)
+        {
+            return (CHAR_TYPE)(ch | (((unsigned)(ch - 'A') < 26u) << 5));
+        }
+
+        inline void WriteLower(CHAR_TYPE const * chars, size_t count)
+        {
+            if (size_ + count <= capacity_)
+            {
+                CHAR_TYPE * dest(dest_ + size_);
+                for (size_t index = 0; index < count; ++index)
+                    dest[index] = Lower(chars[index]);
+                size_ += count;
+            }
+            else
+            {
+                for (size_t index = 0; index < count; ++index)
+                    (*this)(Lower(chars[index]));
+            }
+        }
+
+        inline void Write(CHAR_TYPE const * chars, size_t count)
+        {
+            if (size_ + count <= capacity_)
+            {
+                std::copy(chars, chars + count, dest_ + size_);
+                size_ += count;
+            }
+            else
+            {
+                for (size_t index = 0; index < count; ++index)
+                    (*this)(chars[index]);
+            }
+        }
+
+        inline size_t Size() const
+        {
+            return size_;
+        }
+    };
+
+    // atext of RFC 5322
+    inline bool IsAText(MaxCharType ch)
+    {
+        static char const others[] = "!#$%&'*+-/=?^_`{|}~";
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
+            || (ch > 0 && ch < 128 && std::find(others, others + sizeof(others) - 1, (char)ch) != others + sizeof(others) - 1);
+    }
+
+    // Calls action with the characters of the content of a quoted-string: without the "\" of the quoted pairs
+    // nor the CRLF of the folding white spaces
+    template <typename CHAR_TYPE, typename ACTION>
+    inline void ForEachQuotedChar(CHAR_TYPE const * chars, size_t count, ACTION && action)
+    {
+        for (size_t index = 0; index < count; ++index)
+        {
+            if (chars[index] == '\\' && index + 1 < count)
+                action(chars[++index]);
+            else if (chars[index] != '\r' && chars[index] != '\n')
+                action(chars[index]);
+        }
+    }
+
+    // Whether the content of a quoted-string can be written as a dot-atom-text, without the quotes
+    template <typename CHAR_TYPE>
+    inline bool IsDotAtomText(CHAR_TYPE const * chars, size_t count)
+    {
+        bool valid(true);
+        MaxCharType previous('.');
+        ForEachQuotedChar(chars, count, [&](CHAR_TYPE ch)
+        {
+            valid = valid && (IsAText((MaxCharType)ch) || (ch == '.' && previous != '.'));
+            previous = ch;
+        });
+        return valid && previous != '.';
+    }
+
+    template <typename CHAR_TYPE>
+    inline CHAR_TYPE const * SubstringChars(ParserVector<CHAR_TYPE> const & buffer, SubstringPos & sub)
+    {
+        sub.first = std::min(sub.first, buffer.size());
+        sub.second = std::max(sub.first, std::min(sub.second, buffer.size()));
+        return buffer.data() + sub.first;
+    }
+}
+
+// Writes the canonical form of an addr-spec in dest, that has room for capacity characters:
+// no comments nor folding white spaces, the local part quoted only if needed and the domain in ASCII lowercase.
+// Returns the length of the whole canonical form, only written if not greater than capacity.
+template <typename CHAR_TYPE>
+inline size_t WriteCanonical(CHAR_TYPE * dest, size_t capacity, ParserVector<CHAR_TYPE> const & buffer, AddrSpecData const & addrSpec)
+{
+    Impl::CanonicalWriter<CHAR_TYPE> writer(dest, capacity);
+
+    SubstringPos local(addrSpec.LocalPart.Content);
+    CHAR_TYPE const * localChars(Impl::SubstringChars(buffer, local));
+    SubstringPos domain(addrSpec.DomainPart.Content);
+    CHAR_TYPE const * domainChars(Impl::SubstringChars(buffer, domain));
+
+    // The delimiters are only looked for between the two contents, in the span matched by the addr-spec:
+    // the closing DQUOTE of a quoted-string and the "[" of a domain-literal are there, a dot-atom local part is only
+    // followed by [CFWS] "@", never starting with a DQUOTE, and a dot-atom domain only preceded by "@" [CFWS], never ending with a "["
+    bool const inOrder(local.second < domain.first);
+    if (inOrder && buffer[local.second] == '"')
+    {
+        size_t count(local.second - local.first);
+        if (Impl::IsDotAtomText(localChars, count))
+        {
+            Impl::ForEachQuotedChar(localChars, count, [&](CHAR_TYPE ch) { writer(ch); });
+        }
+        else
+        {
+            writer('"');
+            Impl::ForEachQuotedChar(localChars, count, [&](CHAR_TYPE ch)
+            {
+                if (ch == '"' || ch == '\\')
+                    writer('\\');
+                writer(ch);
+            });
+            writer('"');
+        }
+    }
+    else
+    {
+        writer.Write(localChars, local.second - local.first);
+    }
+
+    writer('@');
+
+    if (inOrder && buffer[domain.first - 1] == '[')
+    {
+        writer('[');
+        for (size_t index = 0; index < domain.second - domain.first; ++index)
+        {
+            CHAR_TYPE ch(domainChars[index]);
+            if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
+                writer(writer.Lower(ch));
+        }
+        writer(']');
+    }
+    else
+    {
+        writer.WriteLower(domainChars, domain.second - domain.first);
+    }
+
+    return writer.Size();
+}
+
+// The address of a mailbox, without its display name
+template <typename CHAR_TYPE>
+inline size_t WriteCanonical(CHAR_TYPE * dest, size_t capacity, ParserVector<CHAR_TYPE> const & buffer, MailboxData const & mailbox)
+{
+    return WriteCanonical(dest, capacity, buffer, IsEmpty(mailbox.NameAddr) ? mailbox.AddrSpec : mailbox.NameAddr.Address.Content);
+}
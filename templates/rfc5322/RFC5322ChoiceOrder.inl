@@ -0,0 +1,31 @@
+// Generated by WriteChoiceOrder() from a parse of a training corpus with PARSER_PROFILE_CHOICES
+
+// AText wins: 752 0 0
+#define RFC5322_ORDER_AText 0, 1, 2
+
+// Address wins: 135 7
+#define RFC5322_ORDER_Address 0, 1
+
+// CContent wins: 159 0 0
+#define RFC5322_ORDER_CContent 0, 1, 2
+
+// CText wins: 0 22 137
+#define RFC5322_ORDER_CText 2, 1, 0
+
+// Domain wins: 248 0
+#define RFC5322_ORDER_Domain 0, 1
+
+// LocalPart wins: 318 33
+#define RFC5322_ORDER_LocalPart 0, 1
+
+// Mailbox wins: 28 148
+#define RFC5322_ORDER_Mailbox 1, 0
+
+// QContent wins: 1077 30
+#define RFC5322_ORDER_QContent 0, 1
+
+// QText wins: 0 236 841
+#define RFC5322_ORDER_QText 2, 1, 0
+
+// Word wins: 201 21
+#define RFC5322_ORDER_Word 0, 1
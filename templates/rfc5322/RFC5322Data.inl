@@ -8,13 +8,15 @@
 
 #include "ParserBase.hpp"
 
+#include <ostream>
+
 NAMEDTUPLE_BEGIN(TextWithCommData)
     NAMEDTUPLE_ITEM(SubstringPos, CommentBefore, )
     NAMEDTUPLE_ITEM(SubstringPos, Content, )
     NAMEDTUPLE_ITEM(SubstringPos, CommentAfter, )
 NAMEDTUPLE_END(TextWithCommData)
 
-using MultiTextWithCommData = std::vector<TextWithCommData>;
+using MultiTextWithCommData = ParserSmallVector<TextWithCommData, 3>;
 
 NAMEDTUPLE_BEGIN(AddrSpecData)
     NAMEDTUPLE_ITEM(TextWithCommData, LocalPart, )
@@ -37,7 +39,7 @@ NAMEDTUPLE_BEGIN(MailboxData)
     NAMEDTUPLE_ITEM(AddrSpecData, AddrSpec, )
 NAMEDTUPLE_END(MailboxData)
 
-using MailboxListData = std::vector<MailboxData>;
+using MailboxListData = ParserSmallVector<MailboxData, 2>;
 
 NAMEDTUPLE_BEGIN(GroupListData)
     NAMEDTUPLE_ITEM(MailboxListData, Mailboxes, )
@@ -55,10 +57,10 @@ NAMEDTUPLE_BEGIN(AddressData)
     NAMEDTUPLE_ITEM(GroupData, Group, )
 NAMEDTUPLE_END(AddressData)
 
-using AddressListData = std::vector<AddressData>;
+using AddressListData = ParserVector<AddressData>;
 
 template <typename CHAR_TYPE>
-std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE> const & buffer, bool withComments, TextWithCommData const & text)
+std::basic_string<CHAR_TYPE> ToString(ParserVector<CHAR_TYPE> const & buffer, bool withComments, TextWithCommData const & text)
 {
     std::basic_string<CHAR_TYPE> result;
 
@@ -75,7 +77,7 @@ std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE> const & buffer, boo
 }
 
 template <typename CHAR_TYPE>
-std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE> const & buffer, bool withComments, MultiTextWithCommData const & text)
+std::basic_string<CHAR_TYPE> ToString(ParserVector<CHAR_TYPE> const & buffer, bool withComments, MultiTextWithCommData const & text)
 {
     std::basic_string<CHAR_TYPE> result;
     for (auto const & part : text)
@@ -86,3 +88,109 @@ std::basic_string<CHAR_TYPE> ToString(std::vector<CHAR_TYPE> const & buffer, boo
     }
     return result;
 }
+
+template <typename CHAR_TYPE>
+std::basic_string_view<CHAR_TYPE> ToStringView(ParserVector<CHAR_TYPE> const & buffer, bool withComments, TextWithCommData const & text)
+{
+    return ToStringView(buffer, withComments ? SubstringPos(text.CommentBefore.first, text.CommentAfter.second) : text.Content);
+}
+
+// The words of a MultiTextWithCommData as ToString() joins them, each one viewed in the buffer
+template <typename CHAR_TYPE>
+class MultiTextView
+{
+    ParserVector<CHAR_TYPE> const * buffer_;
+    TextWithCommData const * begin_;
+    TextWithCommData const * end_;
+    bool withComments_;
+public:
+    class Iterator
+    {
+        MultiTextView const * view_;
+        TextWithCommData const * part_;
+    public:
+        inline Iterator(MultiTextView const * view, TextWithCommData const * part)
+            : view_(view), part_(part)
+        {
+        }
+
+        inline std::basic_string_view<CHAR_TYPE> operator*() const { return ToStringView(*view_->buffer_, view_->withComments_, *part_); }
+        inline Iterator & operator++() { ++part_; return *this; }
+        inline bool operator!=(Iterator const & other) const { return part_ != other.part_; }
+        inline bool operator==(Iterator const & other) const { return part_ == other.part_; }
+    };
+
+    inline MultiTextView(ParserVector<CHAR_TYPE> const & buffer, bool withComments, MultiTextWithCommData const & text)
+        : buffer_(&buffer), begin_(text.data()), end_(text.data() + text.size()), withComments_(withComments)
+    {
+    }
+
+    inline Iterator begin() const { return Iterator(this, begin_); }
+    inline Iterator end() const { return Iterator(this, end_); }
+    inline size_t size() const { return end_ - begin_; }
+
+    // Words are separated by a space without the comments, the comments keep the original spacing
+    inline std::basic_string_view<CHAR_TYPE> Separator() const
+    {
+        return withComments_ ? std::basic_string_view<CHAR_TYPE>() : std::basic_string_view<CHAR_TYPE>(SpaceChar(), 1);
+    }
+
+    // Length of the joined string
+    inline size_t Length() const
+    {
+        size_t length(0);
+        ForEachPiece([&](std::basic_string_view<CHAR_TYPE> piece) { length += piece.size(); });
+        return length;
+    }
+
+    // Calls action with each piece of the joined string, the words and the separators
+    template <typename ACTION>
+    inline void ForEachPiece(ACTION && action) const
+    {
+        bool empty(true);
+        for (auto part : *this)
+        {
+            if (!empty && !Separator().empty())
+                action(Separator());
+            empty = empty && part.empty();
+            if (!part.empty())
+                action(part);
+        }
+    }
+
+    inline bool operator==(std::basic_string_view<CHAR_TYPE> str) const
+    {
+        bool equal(true);
+        ForEachPiece([&](std::basic_string_view<CHAR_TYPE> piece)
+        {
+            equal = equal && str.substr(0, piece.size()) == piece;
+            str.remove_prefix(std::min(piece.size(), str.size()));
+        });
+        return equal && str.empty();
+    }
+
+    inline bool operator!=(std::basic_string_view<CHAR_TYPE> str) const
+    {
+        return !(*this == str);
+    }
+
+private:
+    static inline CHAR_TYPE const * SpaceChar()
+    {
+        static CHAR_TYPE const space(' ');
+        return &space;
+    }
+};
+
+template <typename CHAR_TYPE>
+inline MultiTextView<CHAR_TYPE> ToStringView(ParserVector<CHAR_TYPE> const & buffer, bool withComments, MultiTextWithCommData const & text)
+{
+    return MultiTextView<CHAR_TYPE>(buffer, withComments, text);
+}
+
+template <typename CHAR_TYPE>
+inline std::basic_ostream<CHAR_TYPE> & operator<<(std::basic_ostream<CHAR_TYPE> & os, MultiTextView<CHAR_TYPE> const & text)
+{
+    text.ForEachPiece([&](std::basic_string_view<CHAR_TYPE> piece) { os << piece; });
+    return os;
+}
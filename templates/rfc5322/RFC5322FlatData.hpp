@@ -0,0 +1,278 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// flat data of an address list: one array per kind of item, the items referring to each other by index,
+// instead of the vectors nested in each AddressData
+#pragma once
+
+#include "RFC5322Rules.hpp"
+
+class FlatAddressListData
+{
+public:
+    enum : size_t { NoIndex = SIZE_MAX };
+
+    class AddressItem
+    {
+    public:
+        size_t Mailbox;     // NoIndex for a group
+        size_t Group;       // NoIndex for a mailbox
+    };
+
+    class MailboxItem
+    {
+    public:
+        size_t Address;     // parent address, the group one for the mailboxes of a group
+        size_t Group;       // NoIndex if not in a group
+        size_t FirstWord;   // display name
+        size_t WordsCount;
+        bool IsNameAddr;
+        SubstringPos AngleCommentBefore;
+        SubstringPos AngleCommentAfter;
+        TextWithCommData LocalPart;
+        TextWithCommData DomainPart;
+    };
+
+    class GroupItem
+    {
+    public:
+        size_t Address;
+        size_t FirstWord;
+        size_t WordsCount;
+        size_t FirstMailbox;
+        size_t MailboxesCount;
+        SubstringPos GroupListComment;
+        SubstringPos Comment;
+    };
+
+    ParserVector<AddressItem> Addresses;
+    ParserVector<MailboxItem> Mailboxes;
+    ParserVector<GroupItem> Groups;
+    ParserVector<TextWithCommData> Words;
+
+    // Views on the items, with the names of the fields of the nested data
+
+    template <typename ITEM>
+    class Range
+    {
+        ITEM const * begin_;
+        ITEM const * end_;
+    public:
+        inline Range(ITEM const * begin, ITEM const * end)
+            : begin_(begin), end_(end)
+        {
+        }
+
+        inline ITEM const * begin() const { return begin_; }
+        inline ITEM const * end() const { return end_; }
+        inline size_t size() const { return end_ - begin_; }
+        inline bool empty() const { return begin_ == end_; }
+        inline ITEM const & operator[](size_t index) const { return begin_[index]; }
+    };
+
+    // Iterates on the views of consecutive items
+    template <typename VIEW>
+    class ViewIterator
+    {
+        FlatAddressListData const * data_;
+        size_t index_;
+    public:
+        inline ViewIterator(FlatAddressListData const * data, size_t index)
+            : data_(data), index_(index)
+        {
+        }
+
+        inline VIEW operator*() const { return VIEW(*data_, index_); }
+        inline ViewIterator & operator++() { ++index_; return *this; }
+        inline bool operator!=(ViewIterator const & other) const { return index_ != other.index_; }
+        inline bool operator==(ViewIterator const & other) const { return index_ == other.index_; }
+    };
+
+    template <typename VIEW>
+    class ViewRange
+    {
+        FlatAddressListData const * data_;
+        size_t first_;
+        size_t count_;
+    public:
+        inline ViewRange(FlatAddressListData const & data, size_t first, size_t count)
+            : data_(&data), first_(first), count_(count)
+        {
+        }
+
+        inline ViewIterator<VIEW> begin() const { return ViewIterator<VIEW>(data_, first_); }
+        inline ViewIterator<VIEW> end() const { return ViewIterator<VIEW>(data_, first_ + count_); }
+        inline size_t size() const { return count_; }
+        inline bool empty() const { return count_ == 0; }
+        inline VIEW operator[](size_t index) const { return VIEW(*data_, first_ + index); }
+    };
+
+    class MailboxView
+    {
+        MailboxItem const * item_;
+        FlatAddressListData const * data_;
+    public:
+        inline MailboxView(FlatAddressListData const & data, size_t index)
+            : item_(&data.Mailboxes[index]), data_(&data)
+        {
+        }
+
+        inline bool IsNameAddr() const { return item_->IsNameAddr; }
+        inline Range<TextWithCommData> DisplayName() const
+        {
+            return Range<TextWithCommData>(data_->Words.data() + item_->FirstWord, data_->Words.data() + item_->FirstWord + item_->WordsCount);
+        }
+        inline TextWithCommData const & LocalPart() const { return item_->LocalPart; }
+        inline TextWithCommData const & DomainPart() const { return item_->DomainPart; }
+        inline MailboxItem const & Item() const { return *item_; }
+    };
+
+    class GroupView
+    {
+        GroupItem const * item_;
+        FlatAddressListData const * data_;
+    public:
+        inline GroupView(FlatAddressListData const & data, size_t index)
+            : item_(&data.Groups[index]), data_(&data)
+        {
+        }
+
+        inline Range<TextWithCommData> DisplayName() const
+        {
+            return Range<TextWithCommData>(data_->Words.data() + item_->FirstWord, data_->Words.data() + item_->FirstWord + item_->WordsCount);
+        }
+        inline ViewRange<MailboxView> Mailboxes() const { return ViewRange<MailboxView>(*data_, item_->FirstMailbox, item_->MailboxesCount); }
+        inline SubstringPos const & Comment() const { return item_->Comment; }
+        inline GroupItem const & Item() const { return *item_; }
+    };
+
+    class AddressView
+    {
+        AddressItem const * item_;
+        FlatAddressListData const * data_;
+    public:
+        inline AddressView(FlatAddressListData const & data, size_t index)
+            : item_(&data.Addresses[index]), data_(&data)
+        {
+        }
+
+        inline bool IsGroup() const { return item_->Group != NoIndex; }
+        inline MailboxView Mailbox() const { assert(!IsGroup()); return MailboxView(*data_, item_->Mailbox); }
+        inline GroupView Group() const { assert(IsGroup()); return GroupView(*data_, item_->Group); }
+    };
+
+    // Addresses of the list, mailboxes or groups
+    inline ViewIterator<AddressView> begin() const { return ViewIterator<AddressView>(this, 0); }
+    inline ViewIterator<AddressView> end() const { return ViewIterator<AddressView>(this, Addresses.size()); }
+    inline size_t size() const { return Addresses.size(); }
+    inline bool empty() const { return Addresses.empty(); }
+    inline AddressView operator[](size_t index) const { return AddressView(*this, index); }
+
+    // All the mailboxes, including the ones of the groups
+    inline ViewRange<MailboxView> AllMailboxes() const { return ViewRange<MailboxView>(*this, 0, Mailboxes.size()); }
+
+    inline void clear()
+    {
+        Addresses.clear();
+        Mailboxes.clear();
+        Groups.clear();
+        Words.clear();
+    }
+
+private:
+    inline size_t AddWords(MultiTextWithCommData const & words)
+    {
+        Words.insert(Words.end(), words.begin(), words.end());
+        return Words.size() - words.size();
+    }
+
+    inline void AddMailbox(MailboxData const & mailbox, size_t address, size_t group)
+    {
+        MailboxItem item = {};
+        item.Address = address;
+        item.Group = group;
+        item.IsNameAddr = false == IsEmpty(mailbox.NameAddr);
+        if (item.IsNameAddr)
+        {
+            item.FirstWord = AddWords(mailbox.NameAddr.DisplayName);
+            item.WordsCount = mailbox.NameAddr.DisplayName.size();
+            item.AngleCommentBefore = mailbox.NameAddr.Address.CommentBefore;
+            item.AngleCommentAfter = mailbox.NameAddr.Address.CommentAfter;
+            item.LocalPart = mailbox.NameAddr.Address.Content.LocalPart;
+            item.DomainPart = mailbox.NameAddr.Address.Content.DomainPart;
+        }
+        else
+        {
+            item.FirstWord = Words.size();
+            item.LocalPart = mailbox.AddrSpec.LocalPart;
+            item.DomainPart = mailbox.AddrSpec.DomainPart;
+        }
+        Mailboxes.push_back(item);
+    }
+
+public:
+    // Appends a parsed address, its positions still refer to the output buffer of the parser
+    inline void push_back(AddressData const & address)
+    {
+        AddressItem item = { NoIndex, NoIndex };
+        size_t addressIndex(Addresses.size());
+        if (address.Group.DisplayName.empty())
+        {
+            item.Mailbox = Mailboxes.size();
+            AddMailbox(address.Mailbox, addressIndex, NoIndex);
+        }
+        else
+        {
+            GroupItem group = {};
+            item.Group = Groups.size();
+            group.Address = addressIndex;
+            group.FirstWord = AddWords(address.Group.DisplayName);
+            group.WordsCount = address.Group.DisplayName.size();
+            group.FirstMailbox = Mailboxes.size();
+            group.MailboxesCount = address.Group.GroupList.Mailboxes.size();
+            group.GroupListComment = address.Group.GroupList.Comment;
+            group.Comment = address.Group.Comment;
+            Groups.push_back(group);
+            for (MailboxData const & mailbox : address.Group.GroupList.Mailboxes)
+            {
+                AddMailbox(mailbox, addressIndex, item.Group);
+            }
+        }
+        Addresses.push_back(item);
+    }
+};
+
+namespace RFC5322
+{
+
+// address-list    =   (address *("," address)) / obs-addr-list
+// Parsed address by address into the flat data, the nested data of one address is recycled for the next one.
+template <typename PARSER>
+bool ParseExact(PARSER & parser, FlatAddressListData * result)
+{
+    result->clear();
+    AddressData address;
+    for (;;)
+    {
+        size_t inputPos(parser.Input().Pos());
+        if (result->size() > 0 && ParsePrefix(parser, nullptr, CharVal<','>()) == PrefixNoMatch)
+            break;
+        address.Recycle();
+        if (ParsePrefix(parser, &address, Address()) == PrefixNoMatch)
+        {
+            parser.Input().SetPos(inputPos);
+            break;
+        }
+        result->push_back(address);
+    }
+    if (result->size() > 0 && parser.Ended())
+    {
+        return true;
+    }
+    result->clear();
+    return false;
+}
+
+}
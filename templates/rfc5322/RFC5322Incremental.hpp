@@ -0,0 +1,18 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// address list of a text being edited, parsed again address by address
+#pragma once
+
+#include "ParserIncremental.hpp"
+#include "RFC5322Rules.hpp"
+
+namespace RFC5322
+{
+
+// address-list    =   (address *("," address)) / obs-addr-list
+using IncrementalAddressList = IncrementalParser<AddressListData, Address, CharVal<','> >;
+
+}
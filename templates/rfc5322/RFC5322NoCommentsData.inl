@@ -0,0 +1,45 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// data definitions for the email address parsing without comments
+#pragma once
+
+#include "ParserBase.hpp"
+
+namespace RFC5322NoComments
+{
+
+using MultiTextData = ParserSmallVector<SubstringPos, 3>;
+
+NAMEDTUPLE_BEGIN(AddrSpecData)
+    NAMEDTUPLE_ITEM(SubstringPos, LocalPart, )
+    NAMEDTUPLE_ITEM(SubstringPos, DomainPart, )
+NAMEDTUPLE_END(AddrSpecData)
+
+NAMEDTUPLE_BEGIN(NameAddrData)
+    NAMEDTUPLE_ITEM(MultiTextData, DisplayName, )
+    NAMEDTUPLE_ITEM(AddrSpecData, Address, )
+NAMEDTUPLE_END(NameAddrData)
+
+NAMEDTUPLE_BEGIN(MailboxData)
+    NAMEDTUPLE_ITEM(NameAddrData, NameAddr, )
+    NAMEDTUPLE_ITEM(AddrSpecData, AddrSpec, )
+NAMEDTUPLE_END(MailboxData)
+
+using MailboxListData = ParserSmallVector<MailboxData, 2>;
+
+NAMEDTUPLE_BEGIN(GroupData)
+    NAMEDTUPLE_ITEM(MultiTextData, DisplayName, )
+    NAMEDTUPLE_ITEM(MailboxListData, GroupList, )
+NAMEDTUPLE_END(GroupData)
+
+NAMEDTUPLE_BEGIN(AddressData)
+    NAMEDTUPLE_ITEM(MailboxData, Mailbox, )
+    NAMEDTUPLE_ITEM(GroupData, Group, )
+NAMEDTUPLE_END(AddressData)
+
+using AddressListData = ParserVector<AddressData>;
+
+}
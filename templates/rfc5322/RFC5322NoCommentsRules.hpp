@@ -0,0 +1,74 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// rules definitions for the email address parsing when the comments are not needed:
+// they are matched but neither written to the output nor kept in the data
+#pragma once
+
+#include "RFC5322Rules.hpp"
+#include "RFC5322NoCommentsData.inl"
+
+namespace RFC5322NoComments
+{
+using namespace RFC5234Core;
+using RFC5322::AText;
+using RFC5322::DText;
+using RFC5322::FWS;
+using RFC5322::CFWS;
+using RFC5322::DotAtomText;
+using RFC5322::QContent;
+
+// Same rules as RFC5322, with [CFWS] skipped.
+// Like the Content of the RFC5322 data, the quoted strings of the display names are kept without their delimiters.
+// The parts of an addr-spec keep them, so that they still make a valid addr-spec once joined by "@".
+
+PARSER_RULE(SkipCFWS, Skip(Optional(CFWS())));
+
+PARSER_RULE(Atom, Sequence(SkipCFWS(), Repeat<1>(AText()), SkipCFWS()));
+
+PARSER_RULE(DotAtom, Sequence(SkipCFWS(), DotAtomText(), SkipCFWS()));
+
+PARSER_RULE(QuotedString, Sequence(
+    SkipCFWS(), Skip(DQUOTE()), NoCapture(Sequence(Repeat(Optional(FWS()), QContent()), Optional(FWS()))), Skip(DQUOTE()), SkipCFWS()));
+
+PARSER_RULE(Word, PreferFirst<RFC5322_ORDER_Word>(Alternatives(Atom(), QuotedString())));
+
+PARSER_RULE(Phrase, Repeat<1>(Word()));
+
+PARSER_RULE(DisplayName, Phrase());
+
+PARSER_RULE(QuotedLocalPart, Sequence(
+    SkipCFWS(), NoCapture(Sequence(DQUOTE(), Repeat(Optional(FWS()), QContent()), Optional(FWS()), DQUOTE())), SkipCFWS()));
+
+PARSER_RULE(LocalPart, PreferFirst<RFC5322_ORDER_LocalPart>(Alternatives(DotAtom(), QuotedLocalPart())));
+
+PARSER_RULE(DomainLiteral, Sequence(
+    SkipCFWS(), NoCapture(Sequence(CharVal<'['>(), Repeat(Optional(FWS()), DText()), Optional(FWS()), CharVal<']'>())), SkipCFWS()));
+
+PARSER_RULE(Domain, PreferFirst<RFC5322_ORDER_Domain>(Alternatives(DotAtom(), DomainLiteral())));
+
+PARSER_RULE_DATA(AddrSpec, Sequence(
+    LocalPart(), CharVal<'@'>(), Domain()));
+
+// Once "<" is found, nothing else than an angle-addr can match
+PARSER_RULE(AngleAddr, Sequence(
+    SkipCFWS(), CharVal<'<'>(), Cut(), AddrSpec(), CharVal<'>'>(), SkipCFWS()));
+
+PARSER_RULE_DATA(NameAddr, Sequence(Optional(DisplayName()), AngleAddr()));
+
+PARSER_RULE_DATA(Mailbox, PreferFirst<RFC5322_ORDER_Mailbox>(Union(NameAddr(), AddrSpec())));
+
+PARSER_RULE_DATA(MailboxList, HeadTail(Mailbox(), CharVal<','>(), Mailbox()));
+
+PARSER_RULE(GroupList, Union(MailboxList(), Skip(CFWS())));
+
+PARSER_RULE_DATA(Group, Sequence(
+    DisplayName(), CharVal<':'>(), GroupList(), CharVal<';'>(), SkipCFWS()));
+
+PARSER_RULE_DATA(Address, Prefer<RFC5322_ORDER_Address>(Union(Mailbox(), Group())));
+
+PARSER_RULE_DATA(AddressList, HeadTail(Address(), CharVal<','>(), Address()));
+
+}
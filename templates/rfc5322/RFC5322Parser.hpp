@@ -0,0 +1,31 @@
+// (c) 2019 ptaahfr http://github.com/ptaahfr
+// All right reserved, for educational purposes
+//
+// test parsing code for email adresses based on RFC 5322 & 5234
+//
+// parsing functions of the main rules, compiled once in the RFC5322Parser library.
+// Include it instead of RFC5322Rules.hpp so that the grammar isn't instantiated again.
+#pragma once
+
+#include "ParserIO.hpp"
+#include "RFC5322Data.inl"
+
+namespace RFC5322
+{
+    using StringParser = StringParserIO<char>;
+    using StreamParser = StreamParserIO<char>;
+
+#define RFC5322_PARSER_FUNCTIONS(name) \
+    bool Parse(StringParser & parser, name##Data * result); \
+    bool ParseExact(StringParser & parser, name##Data * result); \
+    bool Parse(StreamParser & parser, name##Data * result); \
+    bool ParseExact(StreamParser & parser, name##Data * result);
+
+    RFC5322_PARSER_FUNCTIONS(AddressList)
+    RFC5322_PARSER_FUNCTIONS(MailboxList)
+    RFC5322_PARSER_FUNCTIONS(Mailbox)
+    RFC5322_PARSER_FUNCTIONS(AddrSpec)
+    RFC5322_PARSER_FUNCTIONS(AngleAddr)
+
+#undef RFC5322_PARSER_FUNCTIONS
+}
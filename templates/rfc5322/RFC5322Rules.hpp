@@ -8,14 +8,18 @@
 
 #include "ParserCore.hpp"
 #include "RFC5322Data.inl"
+// Order of the alternatives, generated by TestRFC5322 built with PARSER_PROFILE_CHOICES
+#include "RFC5322ChoiceOrder.inl"
 
 namespace RFC5322
 {
 using namespace RFC5234Core;
 
 // Rules defined in https://tools.ietf.org/html/rfc5322
+// The choices whose alternatives can't match at the same position keep the first match with PreferFirst<>, in the
+// profiled order. Address may match both ways, Prefer<> only skips Group once a Mailbox reached the end of the input.
 
-PARSER_RULE(AText, Alternatives(ALPHA(), DIGIT(), CharVal< // atext           =   ALPHA / DIGIT /    ; Printable US-ASCII
+PARSER_RULE(AText, PreferFirst<RFC5322_ORDER_AText>(Alternatives(ALPHA(), DIGIT(), CharVal< // atext           =   ALPHA / DIGIT /    ; Printable US-ASCII
                                 '!', '#',                  //                    "!" / "#" /        ;  characters not including
                                 '$', '%',                  //                    "$" / "%" /        ;  specials.  Used for atoms.
                                 '&', '\'',                 //                    "&" / "'" /
@@ -25,13 +29,13 @@ PARSER_RULE(AText, Alternatives(ALPHA(), DIGIT(), CharVal< // atext           =
                                 '^', '_',                  //                    "^" / "_" /
                                 '`', '{',                  //                    "`" / "{" /
                                 '|', '}',                  //                    "|" / "}" /
-                                '~'>()));                  //                    "~"
+                                '~'>())));                 //                    "~"
 
 // ctext           =   %d33-39 /          ; Printable US-ASCII
 //                     %d42-91 /          ;  characters not including
 //                     %d93-126 /         ;  "(", ")", or "\"
 //                     obs-ctext
-PARSER_RULE(CText, Alternatives(CharRange<33, 39>(), CharRange<42, 91>(), CharRange<93, 126>()));
+PARSER_RULE(CText, PreferFirst<RFC5322_ORDER_CText>(Alternatives(CharRange<33, 39>(), CharRange<42, 91>(), CharRange<93, 126>())));
 
 // dtext           =  %d33-90 /          ; Printable US-ASCII
 //                    %d94-126 /         ;  characters not including
@@ -51,7 +55,7 @@ PARSER_RULE(Specials, CharVal<'(', ')', '<', '>', '[', ']', ':', ';', '@', '\\',
 //                     %d35-91 /          ;  characters not including
 //                     %d93-126 /         ;  "\" or the quote character
 //                     obs-qtext
-PARSER_RULE(QText, Alternatives(CharVal<33>(), CharRange<35, 91>(), CharRange<93, 126>()));
+PARSER_RULE(QText, PreferFirst<RFC5322_ORDER_QText>(Alternatives(CharVal<33>(), CharRange<35, 91>(), CharRange<93, 126>())));
 
 // 3.2.2.  Folding White Space and Comments
 
@@ -67,7 +71,7 @@ PARSER_RULE_FORWARD(CContent)
 PARSER_RULE(Comment, Sequence(CharVal<'('>(), Repeat(Optional(FWS()), CContent()), Optional(FWS()), CharVal<')'>()));
 
 // ccontent        =   ctext / quoted-pair / comment
-PARSER_RULE_PARTIAL(CContent, Alternatives(CText(), QuotedPair(), Comment()));
+PARSER_RULE_PARTIAL(CContent, PreferFirst<RFC5322_ORDER_CContent>(Alternatives(CText(), QuotedPair(), Comment())));
 
 // CFWS            =   (1*([FWS] comment) [FWS]) / FWS
 PARSER_RULE(CFWS, Alternatives(Repeat<1>(Optional(FWS()), Comment()), Optional(FWS()), FWS()));
@@ -76,13 +80,13 @@ PARSER_RULE(CFWS, Alternatives(Repeat<1>(Optional(FWS()), Comment()), Optional(F
 PARSER_RULE(Atom, Sequence(Optional(CFWS()), Repeat<1>(AText()), Optional(CFWS())));
 
 // dot-atom-text   =   1*atext *("." 1*atext)
-PARSER_RULE(DotAtomText, Sequence(Repeat<1>(AText()), Repeat(CharVal<'.'>(), Repeat<1>(AText()))));
+PARSER_RULE(DotAtomText, Regular(Sequence(Repeat<1>(AText()), Repeat(CharVal<'.'>(), Repeat<1>(AText())))));
 
 // dot-atom        =   [CFWS] dot-atom-text [CFWS]
 PARSER_RULE(DotAtom, Sequence(Optional(CFWS()), DotAtomText(), Optional(CFWS())));
 
 // qcontent        =   qtext / quoted-pair
-PARSER_RULE(QContent, Alternatives(QText(), QuotedPair()));
+PARSER_RULE(QContent, PreferFirst<RFC5322_ORDER_QContent>(Alternatives(QText(), QuotedPair())));
 
 PARSER_RULE(QuotedString, Sequence(
     Optional(CFWS()),                                                                   // quoted-string   =   [CFWS]
@@ -92,7 +96,7 @@ PARSER_RULE(QuotedString, Sequence(
 // 3.2.5.  Miscellaneous Tokens
 
 // word            =   atom / quoted-string
-PARSER_RULE(Word, Alternatives(Atom(), QuotedString()));
+PARSER_RULE(Word, PreferFirst<RFC5322_ORDER_Word>(Alternatives(Atom(), QuotedString())));
 
 // phrase          =   1*word / obs-phrase
 PARSER_RULE(Phrase, Repeat<1>(Word()));
@@ -103,14 +107,14 @@ PARSER_RULE(DisplayName, Phrase());
 // 3.4.1.  Addr-Spec Specification
 
 // local-part      =   dot-atom / quoted-string / obs-local-part
-PARSER_RULE(LocalPart, Alternatives(DotAtom(), QuotedString()));
+PARSER_RULE(LocalPart, PreferFirst<RFC5322_ORDER_LocalPart>(Alternatives(DotAtom(), QuotedString())));
 
 // domain-literal  =   [CFWS] "[" *([FWS] dtext) [FWS] "]" [CFWS]
 PARSER_RULE(DomainLiteral, Sequence(
     Optional(CFWS()), CharVal<'['>(), Sequence(Repeat(Optional(FWS()), DText()), Optional(FWS())), CharVal<']'>(), Optional(CFWS())));
 
 // domain          =   dot-atom / domain-literal / obs-domain
-PARSER_RULE(Domain, Alternatives(DotAtom(), DomainLiteral()));
+PARSER_RULE(Domain, PreferFirst<RFC5322_ORDER_Domain>(Alternatives(DotAtom(), DomainLiteral())));
 
 // addr-spec       =   local-part "@" domain
 PARSER_RULE_DATA(AddrSpec, Sequence(
@@ -120,14 +124,16 @@ PARSER_RULE_DATA(AddrSpec, Sequence(
 
 // angle-addr      =   [CFWS] "<" addr-spec ">" [CFWS] /
 //                 obs-angle-addr
+// Once "<" is found, nothing else than an angle-addr can match
 PARSER_RULE_DATA(AngleAddr, Sequence(
-    Optional(CFWS()), CharVal<'<'>(), AddrSpec(), CharVal<'>'>(), Optional(CFWS())));
+    Optional(CFWS()), CharVal<'<'>(), Cut(), AddrSpec(), CharVal<'>'>(), Optional(CFWS())));
 
 // name-addr       =   [display-name] angle-addr
 PARSER_RULE_DATA(NameAddr, Sequence(Optional(DisplayName()), AngleAddr()));
 
 // mailbox         =   name-addr / addr-spec
-PARSER_RULE_DATA(Mailbox, Union(NameAddr(), AddrSpec()));
+// A name-addr needs a "<" where an addr-spec can't have one: the first alternative to match is the only one
+PARSER_RULE_DATA(Mailbox, PreferFirst<RFC5322_ORDER_Mailbox>(Union(NameAddr(), AddrSpec())));
 
 // mailbox-list    =   (mailbox *("," mailbox)) / obs-mbox-list
 PARSER_RULE_DATA(MailboxList, HeadTail(Mailbox(), CharVal<','>(), Mailbox()));
@@ -140,9 +146,13 @@ PARSER_RULE_DATA(Group, Sequence(
     DisplayName(), CharVal<':'>(), GroupList(), CharVal<';'>(), Optional(CFWS())));
 
 // address         =   mailbox / group
-PARSER_RULE_DATA(Address, Union(Mailbox(), Group()));
+PARSER_RULE_DATA(Address, Prefer<RFC5322_ORDER_Address>(Union(Mailbox(), Group())));
 
 // address-list    =   (address *("," address)) / obs-addr-list
 PARSER_RULE_DATA(AddressList, HeadTail(Address(), CharVal<','>(), Address()));
 
+// Parts of an addr-spec parsed alone, e.g. ParseExact(parser, &domain, AddrSpec()) with an AddrSpecDomain domain
+using AddrSpecDomain = Projection<AddrSpecData, NAMEDTUPLE_INDEX(AddrSpecData, DomainPart), NAMEDTUPLE_INDEX(TextWithCommData, Content)>;
+using AddrSpecLocalPart = Projection<AddrSpecData, NAMEDTUPLE_INDEX(AddrSpecData, LocalPart), NAMEDTUPLE_INDEX(TextWithCommData, Content)>;
+
 }